@@ -0,0 +1,35 @@
+#!/bin/sh
+# Generate a single-file amalgamation of libyasl.
+#
+# The headers and the sources listed in src/meson.build are concatenated into
+# one C file, which can be compiled into a program instead of the library, or
+# included into one of its source files so that the compiler can inline yasl
+# into the calling code without LTO. Other files keep including the regular
+# headers.
+#
+# Usage: contrib/amalgamate.sh [output]
+
+set -e
+
+top=$(cd "$(dirname "$0")/.." && pwd)
+out=${1:-yasl-amalgamation.c}
+
+# yasl.c comes last, since it undefines the inline fast paths of yasl.h.
+sources=$(sed -n "s/^yasl_sources *= *\[\(.*\)\]/\1/p" "$top/src/meson.build" |
+          tr -d "'," | tr ' ' '\n' | grep -v '^yasl\.c$')
+sources="$sources yasl.c"
+
+{
+	printf '/* Amalgamation of yasl, generated by contrib/amalgamate.sh. */\n'
+	for f in "$top"/include/yasl.h "$top"/include/*.h; do
+		case $f in
+		*/yasl.h) [ -n "$header_done" ] && continue; header_done=1 ;;
+		esac
+		printf '\n/*** %s ***/\n' "include/$(basename "$f")"
+		sed '/^#include "[a-z]*\.h"$/d' "$f"
+	done
+	for f in $sources; do
+		printf '\n/*** %s ***/\n' "src/$f"
+		sed '/^#include "[a-z]*\.h"$/d' "$top/src/$f"
+	done
+} > "$out"
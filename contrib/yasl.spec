@@ -44,6 +44,21 @@ Development files for yasl
 %{_libdir}/libyasl.so
 %{_libdir}/pkgconfig/libyasl.pc
 %{_includedir}/yasl.h
+%{_includedir}/yaslcsv.h
+%{_includedir}/yaslsort.h
+%{_includedir}/yasllz.h
+%{_includedir}/yasltpl.h
+%{_includedir}/yaslac.h
+%{_includedir}/yaslglob.h
+%{_includedir}/yaslmap.h
+%{_includedir}/yaslrax.h
+%{_includedir}/yasldist.h
+%{_includedir}/yaslsa.h
+%{_includedir}/yaslbuf.h
+%{_includedir}/yaslsnap.h
+%{_includedir}/yaslfc.h
+%{_includedir}/yaslresp.h
+%{_includedir}/yasl.hpp
 
 %post -p /sbin/ldconfig
 
@@ -16,20 +16,62 @@
 #endif
 
 #define YASL_MAX_PREALLOC (1024*1024)
+#define YASL_MIN_COMPACT (4*1024)
 
 #include <stdarg.h>
 #include <stddef.h>
 #include <string.h>
 #include <sys/types.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef char *yastr;
 
-struct yastrhdr {
+/* The string lives in read-only static storage, see YASL_LITERAL(). */
+#define YASL_STATIC 1
+
+/* The bits of the flags above this shift hold the number of bytes consumed
+ * from the front of the allocation by yaslconsume(). */
+#define YASL_HEAD_SHIFT 1
+
+/* Packed, since yaslconsume() moves the header along with the start of the
+ * string to any byte offset. This does not change its size, and where loads
+ * may be unaligned, as on x86-64, not the code reading it either; targets that
+ * need aligned loads read its fields a byte at a time instead. */
+struct __attribute__((__packed__)) yastrhdr {
 	size_t len;
 	size_t free;
+	size_t flags;
 	char buf[];
 };
 
+/* Define 'name' as a yasl string holding the string literal 'lit', with its
+ * header and contents in read-only static storage. Nothing is allocated, and
+ * the string is never freed or modified: yaslfree() ignores it, functions that
+ * return a modified string return a modified copy, and the other functions
+ * that modify a string in place must not be given it: they assert that, and
+ * leave it untouched when assertions are disabled. */
+#define YASL_LITERAL(name, lit) \
+	static const struct { \
+		size_t len; \
+		size_t free; \
+		size_t flags; \
+		char buf[sizeof(lit)]; \
+	} name##_yaslhdr = { sizeof(lit) - 1, 0, YASL_STATIC, lit }; \
+	static const yastr name = (yastr)name##_yaslhdr.buf
+
+/* A vector of strings packed back to back into the single yasl string 'data',
+ * each followed by a null byte. Element 'i' starts at 'offsets[i]', and
+ * 'offsets[count]' is the end of the last element. */
+struct yaslvec {
+	yastr data;
+	size_t * offsets;
+	size_t count;
+	size_t slots;
+};
+
 
 /**
  * User API function prototypes
@@ -51,6 +93,9 @@ yaslempty(void);
 yastr
 yaslfromlonglong(long long value);
 
+void
+yaslvecinit(struct yaslvec * vec);
+
 
 // Querying //
 static inline size_t
@@ -62,6 +107,27 @@ yasllen(const yastr str);
 int
 yaslcmp(const yastr str1, const yastr str2);
 
+ptrdiff_t
+yaslfind(const yastr str, const char * needle, size_t needlelen);
+
+ptrdiff_t
+yaslrfind(const yastr str, const char * needle, size_t needlelen);
+
+size_t
+yaslcount(const yastr str, const char * needle, size_t needlelen);
+
+int
+yaslutf8valid(const yastr str);
+
+size_t
+yaslutf8len(const yastr str);
+
+static inline const char *
+yaslvecget(const struct yaslvec * vec, size_t i);
+
+static inline size_t
+yaslveclen(const struct yaslvec * vec, size_t i);
+
 
 // Modification //
 void
@@ -82,15 +148,30 @@ yasljoin(char ** argv, int argc, char * sep, size_t seplen);
 yastr
 yasljoinyasl(yastr * argv, int argc, const char * sep, size_t seplen);
 
+yastr
+yasljoinvec(const struct yaslvec * vec, const char * sep, size_t seplen);
+
 yastr
 yaslmapchars(yastr str, const char * from, const char * to, size_t setlen);
 
 void
 yaslrange(yastr str, ptrdiff_t start, ptrdiff_t end);
 
+yastr
+yaslconsume(yastr str, size_t len);
+
+yastr
+yaslreplace(yastr str, const char * from, size_t fromlen, const char * to, size_t tolen);
+
 void
 yaslstrip(yastr str, const char * cset);
 
+void
+yaslutf8range(yastr str, ptrdiff_t start, ptrdiff_t end);
+
+void
+yaslutf8trunc(yastr str, size_t maxlen);
+
 void
 yasltolower(yastr str);
 
@@ -109,6 +190,24 @@ yaslsplitargs(const char * line, int * argc);
 yastr *
 yaslsplitlen(const char * str, size_t len, const char * sep, size_t seplen, size_t * count);
 
+int
+yaslsplitargsvec(struct yaslvec * vec, const char * line);
+
+int
+yaslsplitlenvec(struct yaslvec * vec, const char * str, size_t len, const char * sep, size_t seplen);
+
+int
+yaslvecappend(struct yaslvec * vec, const void * str, size_t len);
+
+int
+yaslvecfromarray(struct yaslvec * vec, yastr * argv, size_t count);
+
+yastr *
+yaslvectoarray(const struct yaslvec * vec);
+
+void
+yaslvecclear(struct yaslvec * vec);
+
 
 // Concatenation //
 yastr
@@ -120,9 +219,48 @@ yaslcatyasl(yastr dest, const yastr src);
 yastr
 yaslcatlen(yastr dest, const void * src, size_t len);
 
+yastr
+yaslcatlonglong(yastr dest, long long value);
+
+yastr
+yaslcatulonglong(yastr dest, unsigned long long value);
+
 yastr
 yaslcatrepr(yastr dest, const char * src, size_t len);
 
+yastr
+yaslcatutf8(yastr dest, const char * src, size_t len);
+
+yastr
+yaslcathex(yastr dest, const void * src, size_t len);
+
+yastr
+yaslcatunhex(yastr dest, const char * src, size_t len);
+
+yastr
+yaslcatbase64(yastr dest, const void * src, size_t len);
+
+yastr
+yaslcatbase64url(yastr dest, const void * src, size_t len);
+
+yastr
+yaslcatunbase64(yastr dest, const char * src, size_t len);
+
+yastr
+yaslcatunbase64url(yastr dest, const char * src, size_t len);
+
+yastr
+yaslcatpercent(yastr dest, const void * src, size_t len);
+
+yastr
+yaslcatunpercent(yastr dest, const char * src, size_t len);
+
+yastr
+yaslcatjson(yastr dest, const char * src, size_t len, int ascii);
+
+yastr
+yaslcatunjson(yastr dest, const char * src, size_t len);
+
 yastr
 yaslcatvprintf(yastr str, const char * fmt, va_list ap);
 
@@ -138,6 +276,9 @@ yaslfree(yastr str);
 void
 yaslfreesplitres(yastr * tokens, size_t count);
 
+void
+yaslvecfree(struct yaslvec * vec);
+
 
 // Low-level functions //
 static inline struct yastrhdr *
@@ -170,9 +311,11 @@ hex_digit_to_int(char c);
 static inline struct yastrhdr *yaslheader(const yastr str) {
 	if (!str) { return NULL; }
 
-	/* The yastrhdr pointer has a different alignment than the original char
-	 * pointer, so cast it through a void pointer to silence the warning. */
-	return (void *)(str - offsetof(struct yastrhdr, buf));
+	/* Since yaslconsume() moves the start of a string, its header may sit at
+	 * any byte offset, which is why struct yastrhdr is packed. The cast goes
+	 * through a void pointer to make clear that this char pointer is used as
+	 * a header on purpose. */
+	return (struct yastrhdr *)(void *)(str - offsetof(struct yastrhdr, buf));
 }
 
 static inline yastr yaslauto(const char * str) {
@@ -191,5 +334,93 @@ static inline size_t yasllen(const yastr str) {
 	return yaslheader(str)->len;
 }
 
+static inline const char * yaslvecget(const struct yaslvec * vec, size_t i) {
+	return vec->data + vec->offsets[i];
+}
+
+static inline size_t yaslveclen(const struct yaslvec * vec, size_t i) {
+	return vec->offsets[i + 1] - vec->offsets[i] - 1;
+}
+
+/* Fast paths for the common cases where a string already has room for the
+ * change, which are inlined into the caller instead of going through a call
+ * into the library. Everything else, including NULL arguments and static
+ * strings, falls back to the out-of-line function. Define YASL_NO_INLINE
+ * before including this header to always call the library. */
+#ifndef YASL_NO_INLINE
+
+static inline __attribute__((warn_unused_result))
+yastr yaslMakeRoomForFast(yastr str, size_t addlen) {
+	struct yastrhdr * hdr = yaslheader(str);
+
+	if (!hdr || (hdr->flags & YASL_STATIC) || hdr->free < addlen) {
+		return (yaslMakeRoomFor)(str, addlen);
+	}
+	return str;
+}
+
+static inline void yaslIncrLenFast(yastr str, size_t incr) {
+	struct yastrhdr * hdr = yaslheader(str);
+
+	if (!hdr || (hdr->flags & YASL_STATIC) || hdr->free < incr) {
+		(yaslIncrLen)(str, incr);
+		return;
+	}
+	hdr->len += incr;
+	hdr->free -= incr;
+	str[hdr->len] = '\0';
+}
+
+static inline yastr yaslcatlenFast(yastr dest, const void * src, size_t len) {
+	struct yastrhdr * hdr = yaslheader(dest);
+
+	if (!hdr || !src || (hdr->flags & YASL_STATIC) || hdr->free < len) {
+		return (yaslcatlen)(dest, src, len);
+	}
+	memcpy(dest + hdr->len, src, len);
+	hdr->len += len;
+	hdr->free -= len;
+	dest[hdr->len] = '\0';
+	return dest;
+}
+
+static inline yastr yaslcatFast(yastr dest, const char * src) {
+	if (!src) { return (yaslcat)(dest, src); }
+
+	return yaslcatlenFast(dest, src, strlen(src));
+}
+
+static inline yastr yaslcatyaslFast(yastr dest, const yastr src) {
+	if (!src) { return (yaslcatyasl)(dest, src); }
+
+	return yaslcatlenFast(dest, src, yasllen(src));
+}
+
+static inline yastr yaslcpylenFast(yastr dest, const char * src, size_t len) {
+	struct yastrhdr * hdr = yaslheader(dest);
+
+	if (!hdr || !src || (hdr->flags & YASL_STATIC) || hdr->len + hdr->free < len) {
+		return (yaslcpylen)(dest, src, len);
+	}
+	memcpy(dest, src, len);
+	dest[len] = '\0';
+	hdr->free += hdr->len;
+	hdr->free -= len;
+	hdr->len = len;
+	return dest;
+}
+
+#define yaslMakeRoomFor(str, addlen) yaslMakeRoomForFast(str, addlen)
+#define yaslIncrLen(str, incr) yaslIncrLenFast(str, incr)
+#define yaslcatlen(dest, src, len) yaslcatlenFast(dest, src, len)
+#define yaslcat(dest, src) yaslcatFast(dest, src)
+#define yaslcatyasl(dest, src) yaslcatyaslFast(dest, src)
+#define yaslcpylen(dest, src, len) yaslcpylenFast(dest, src, len)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,325 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASL_HPP
+#define YASL_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string_view>
+#include <type_traits>
+
+#include "yasl.h"
+
+namespace yasl {
+
+/* Whether 'T' is a lazy concatenation, see operator+ below. */
+template <class T>
+struct is_expr : std::false_type {};
+
+template <class T>
+inline constexpr bool is_expr_v = is_expr<T>::value;
+
+/* An owning yasl string for C++17, freed with yaslfree() when it goes out of
+ * scope. It can be moved but not copied, so that copies with yasldup() are
+ * always explicit, see dup(). It converts to std::string_view without a copy,
+ * and allocation failures throw std::bad_alloc.
+ *
+ * A moved-from string is NULL, and behaves like an empty string. */
+class string {
+public:
+	string() : s_(check(yaslempty())) {}
+
+	explicit string(std::string_view sv) : s_(check(yaslnew(sv.data(), sv.size()))) {}
+
+	/* Render a concatenation into a string of the exact length. */
+	template <class E, class = std::enable_if_t<is_expr_v<E>>>
+	string(const E & e) : s_(check(yaslnew(nullptr, e.size()))) {
+		e.write(s_);
+	}
+
+	string(string && other) noexcept : s_(other.s_) { other.s_ = nullptr; }
+
+	string & operator=(string && other) noexcept {
+		if (this != &other) {
+			yaslfree(s_);
+			s_ = other.s_;
+			other.s_ = nullptr;
+		}
+		return *this;
+	}
+
+	string(const string &) = delete;
+	string & operator=(const string &) = delete;
+
+	~string() { yaslfree(s_); }
+
+	/* Take ownership of 's', which must not be freed by the caller anymore. */
+	static string adopt(yastr s) noexcept {
+		string str(nullptr);
+		str.s_ = s;
+		return str;
+	}
+
+	/* Give up ownership of the yasl string, which the caller must free. */
+	yastr release() noexcept {
+		yastr s = s_;
+		s_ = nullptr;
+		return s;
+	}
+
+	string dup() const { return adopt(check(yaslnew(data(), size()))); }
+
+	yastr get() const noexcept { return s_; }
+	const char * data() const noexcept { return s_ ? s_ : ""; }
+	const char * c_str() const noexcept { return data(); }
+	char * data() noexcept { return s_; }
+	std::size_t size() const noexcept { return yasllen(s_); }
+	std::size_t capacity() const noexcept { return yasllen(s_) + yaslavail(s_); }
+	bool empty() const noexcept { return !size(); }
+
+	std::string_view view() const noexcept { return std::string_view(data(), size()); }
+	operator std::string_view() const noexcept { return view(); }
+
+	char & operator[](std::size_t i) noexcept { return s_[i]; }
+	char operator[](std::size_t i) const noexcept { return s_[i]; }
+
+	/* Make room for a total of 'n' bytes, with yaslMakeRoomFor(). */
+	string & reserve(std::size_t n) {
+		if (n > size()) { s_ = check(yaslMakeRoomFor(own(), n - size())); }
+		return *this;
+	}
+
+	/* Append bytes with yaslcatlen(). */
+	string & append(const void * src, std::size_t len) {
+		if (len) { s_ = check(yaslcatlen(own(), src, len)); }
+		return *this;
+	}
+
+	string & append(std::string_view sv) { return append(sv.data(), sv.size()); }
+	string & append(const string & str) { return append(str.data(), str.size()); }
+	string & append(char c) { return append(&c, 1); }
+
+	string & operator+=(std::string_view sv) { return append(sv); }
+	string & operator+=(const string & str) { return append(str); }
+	string & operator+=(char c) { return append(c); }
+
+	/* Append a concatenation, growing the string at most once. Pieces that
+	 * are this string itself are fine, but not yasl::ref() of it. */
+	template <class E, class = std::enable_if_t<is_expr_v<E>>>
+	string & operator+=(const E & e) {
+		std::size_t n = e.size();
+
+		s_ = check(yaslMakeRoomFor(own(), n));
+		e.write(s_ + yasllen(s_));
+		yaslIncrLen(s_, n);
+		return *this;
+	}
+
+	template <class E, class = std::enable_if_t<is_expr_v<E>>>
+	string & operator=(const E & e) { return *this = string(e); }
+
+	void clear() noexcept { yaslclear(s_); }
+
+	friend bool operator==(const string & a, const string & b) noexcept { return a.view() == b.view(); }
+	friend bool operator!=(const string & a, const string & b) noexcept { return a.view() != b.view(); }
+	friend bool operator<(const string & a, const string & b) noexcept { return a.view() < b.view(); }
+
+private:
+	explicit string(std::nullptr_t) noexcept : s_(nullptr) {}
+
+	static yastr check(yastr s) {
+		if (!s) { throw std::bad_alloc(); }
+		return s;
+	}
+
+	yastr own() {
+		if (!s_) { s_ = check(yaslempty()); }
+		return s_;
+	}
+
+	yastr s_;
+};
+
+/* Lazy concatenation. Adding anything to a yasl::string, to the result of
+ * yasl::ref(), or to another concatenation builds an expression instead of a
+ * string, which is only rendered when it is assigned to or appended to a
+ * yasl::string. Its length is computed first, the string grows once, and
+ * every piece is copied into it in a single pass:
+ *
+ *     yasl::string key = prefix + yasl::ref(id) + ':' + 42 + "/" + view;
+ *
+ * Pieces may be yasl strings, anything that converts to std::string_view,
+ * like string literals and std::string, chars, and integers, which are
+ * written in decimal. A plain char * is read up to its null byte, so wrap a
+ * yastr in yasl::ref() to use its length instead. Like any expression
+ * template, a concatenation refers to its pieces, and must not outlive them. */
+
+template <class L, class R>
+class cat {
+public:
+	cat(const L & l, const R & r) : l_(l), r_(r) {}
+
+	std::size_t size() const noexcept { return l_.size() + r_.size(); }
+	char * write(char * p) const noexcept { return r_.write(l_.write(p)); }
+
+private:
+	L l_;
+	R r_;
+};
+
+/* A run of bytes, like a string_view. */
+class bytes {
+public:
+	bytes(const char * p, std::size_t n) noexcept : p_(p), n_(n) {}
+
+	std::size_t size() const noexcept { return n_; }
+
+	char * write(char * p) const noexcept {
+		if (n_) { std::memcpy(p, p_, n_); }
+		return p + n_;
+	}
+
+private:
+	const char * p_;
+	std::size_t n_;
+};
+
+/* Use the yasl string 's' as a piece of a concatenation. */
+inline bytes
+ref(const yastr s) noexcept {
+	return bytes(s ? s : "", yasllen(s));
+}
+
+namespace detail {
+
+class strref {
+public:
+	explicit strref(const string & s) noexcept : s_(&s) {}
+
+	std::size_t size() const noexcept { return s_->size(); }
+
+	char * write(char * p) const noexcept {
+		std::size_t n = s_->size();
+
+		if (n) { std::memcpy(p, s_->data(), n); }
+		return p + n;
+	}
+
+private:
+	const string * s_;
+};
+
+class chr {
+public:
+	explicit chr(char c) noexcept : c_(c) {}
+
+	std::size_t size() const noexcept { return 1; }
+
+	char * write(char * p) const noexcept {
+		*p = c_;
+		return p + 1;
+	}
+
+private:
+	char c_;
+};
+
+class num {
+public:
+	template <class T>
+	explicit num(T v) noexcept : neg_(negative(v)), len_(neg_) {
+		mag_ = neg_ ? 0ULL - static_cast<unsigned long long>(v)
+		            : static_cast<unsigned long long>(v);
+		for (unsigned long long m = mag_; ; m /= 10) {
+			len_++;
+			if (m < 10) { break; }
+		}
+	}
+
+	std::size_t size() const noexcept { return len_; }
+
+	char * write(char * p) const noexcept {
+		char * end = p + len_;
+		unsigned long long m = mag_;
+
+		do {
+			*--end = static_cast<char>('0' + m % 10);
+			m /= 10;
+		} while (m);
+		if (neg_) { *p = '-'; }
+		return p + len_;
+	}
+
+private:
+	template <class T>
+	static bool negative(T v) noexcept {
+		if constexpr (std::is_signed_v<T>) { return v < 0; }
+		return false;
+	}
+
+	unsigned long long mag_;
+	bool neg_;
+	unsigned char len_;
+};
+
+inline strref piece(const string & s) noexcept { return strref(s); }
+inline chr piece(char c) noexcept { return chr(c); }
+
+template <class L, class R>
+cat<L, R> piece(const cat<L, R> & e) noexcept { return e; }
+
+inline bytes piece(const bytes & b) noexcept { return b; }
+
+template <class T, class = std::enable_if_t<std::is_integral_v<T>
+                                            && !std::is_same_v<T, bool>
+                                            && !std::is_same_v<T, char>>>
+num piece(T v) noexcept { return num(v); }
+
+template <class T, class = std::enable_if_t<!is_expr_v<T>
+                                            && std::is_convertible_v<const T &, std::string_view>>>
+bytes piece(const T & s) noexcept {
+	std::string_view sv(s);
+
+	return bytes(sv.data(), sv.size());
+}
+
+} // namespace detail
+
+template <class L, class R>
+struct is_expr<cat<L, R>> : std::true_type {};
+
+template <>
+struct is_expr<bytes> : std::true_type {};
+
+template <class L, class R,
+          class = std::enable_if_t<is_expr_v<L> || is_expr_v<R>
+                                   || std::is_same_v<L, string> || std::is_same_v<R, string>>>
+auto
+operator+(const L & l, const R & r) {
+	using detail::piece;
+
+	return cat<decltype(piece(l)), decltype(piece(r))>(piece(l), piece(r));
+}
+
+} // namespace yasl
+
+namespace std {
+
+template <>
+struct hash<yasl::string> {
+	size_t operator()(const yasl::string & str) const noexcept {
+		return hash<string_view>()(str.view());
+	}
+};
+
+} // namespace std
+
+#endif
@@ -0,0 +1,68 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLAC_H
+#define YASLAC_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Called for every match of the pattern with index 'id' in the array passed to
+ * yaslacnew(), which starts at byte 'offset' of the scanned text, or of the
+ * stream for yaslacfeed(). A non-zero return value stops the scan and is
+ * returned from yaslacscan() or yaslacfeed(). */
+typedef int (*yaslacmatchfn)(size_t id, size_t offset, void * ctx);
+
+/* The state of a scan of text split into chunks, see yaslacfeed(). */
+struct yaslacstream {
+	size_t state;
+	size_t offset;               /* bytes fed so far */
+};
+
+struct yaslac;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslac *
+yaslacnew(const yastr * patterns, size_t count);
+
+void
+yaslacstreaminit(struct yaslacstream * stream);
+
+
+// Querying //
+ptrdiff_t
+yaslacfind(const struct yaslac * ac, const char * src, size_t len, size_t * id);
+
+int
+yaslacscan(const struct yaslac * ac, const char * src, size_t len, yaslacmatchfn fn, void * ctx);
+
+
+// Modification //
+int
+yaslacfeed(const struct yaslac * ac, struct yaslacstream * stream, const char * chunk, size_t len, yaslacmatchfn fn, void * ctx);
+
+
+// Freeing //
+void
+yaslacfree(struct yaslac * ac);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
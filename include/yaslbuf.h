@@ -0,0 +1,60 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLBUF_H
+#define YASLBUF_H
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yaslbuf;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslbuf *
+yaslbufnew(size_t segsize, size_t segments);
+
+
+// Querying //
+size_t
+yaslbufpeek(struct yaslbuf * buf, struct iovec * iov, size_t max);
+
+
+// Modification //
+int
+yaslbufappend(struct yaslbuf * buf, const void * src, size_t len);
+
+void
+yaslbufflush(struct yaslbuf * buf);
+
+void
+yaslbufrelease(struct yaslbuf * buf, size_t count);
+
+yastr
+yaslbufpop(struct yaslbuf * buf);
+
+
+// Freeing //
+void
+yaslbuffree(struct yaslbuf * buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
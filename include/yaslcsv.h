@@ -0,0 +1,60 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLCSV_H
+#define YASLCSV_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A field of a parsed row. The data points either into the chunk passed to
+ * yaslcsvfeed(), or into a buffer owned by the parser, and is only valid for
+ * the duration of the row callback. It is not null terminated. */
+struct yaslcsvfield {
+	const char * data;
+	size_t len;
+};
+
+/* Called for every complete row. A non-zero return value stops the parser and
+ * is returned from yaslcsvfeed() or yaslcsvfinish(). */
+typedef int (*yaslcsvrowfn)(const struct yaslcsvfield * fields, size_t count, void * ctx);
+
+struct yaslcsv;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslcsv *
+yaslcsvnew(char sep, char quote);
+
+
+// Modification //
+int
+yaslcsvfeed(struct yaslcsv * csv, const char * chunk, size_t len, yaslcsvrowfn fn, void * ctx);
+
+int
+yaslcsvfinish(struct yaslcsv * csv, yaslcsvrowfn fn, void * ctx);
+
+
+// Freeing //
+void
+yaslcsvfree(struct yaslcsv * csv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
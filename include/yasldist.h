@@ -0,0 +1,51 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLDIST_H
+#define YASLDIST_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yasldist;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yasldist *
+yasldistnew(const char * pattern, size_t len);
+
+
+// Querying //
+ptrdiff_t
+yasldistance(const char * a, size_t alen, const char * b, size_t blen, size_t max);
+
+ptrdiff_t
+yasldistmatch(struct yasldist * dist, const char * str, size_t len, size_t max);
+
+size_t
+yasldistfilter(struct yasldist * dist, const yastr * strs, size_t count, size_t max, ptrdiff_t * distances);
+
+
+// Freeing //
+void
+yasldistfree(struct yasldist * dist);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLFC_H
+#define YASLFC_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yaslfc;
+
+/* An iterator over the keys of a front-coded array in order, which decodes
+ * them one after the other into the same string, see yaslfcseek() and
+ * yaslfcnext(). */
+struct yaslfciter {
+	yastr key;                   /* the current key */
+	size_t index;                /* and its index */
+	const struct yaslfc * fc;
+	size_t next;                 /* the index of the next key */
+	size_t pos;                  /* and its offset in the blocks */
+};
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslfc *
+yaslfcnew(const yastr * strs, size_t count, size_t interval);
+
+void
+yaslfciterinit(struct yaslfciter * it, const struct yaslfc * fc);
+
+
+// Querying //
+size_t
+yaslfccount(const struct yaslfc * fc);
+
+size_t
+yaslfcsize(const struct yaslfc * fc);
+
+ptrdiff_t
+yaslfcfind(const struct yaslfc * fc, const char * key, size_t len);
+
+int
+yaslfcseek(struct yaslfciter * it, const char * key, size_t len);
+
+int
+yaslfcnext(struct yaslfciter * it);
+
+
+// Concatenation //
+yastr
+yaslcatfc(yastr dest, const struct yaslfc * fc, size_t index);
+
+
+// Freeing //
+void
+yaslfcfree(struct yaslfc * fc);
+
+void
+yaslfciterfree(struct yaslfciter * it);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
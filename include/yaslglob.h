@@ -0,0 +1,51 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLGLOB_H
+#define YASLGLOB_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Match ASCII letters regardless of case. */
+#define YASLGLOB_NOCASE 1
+
+struct yaslglob;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslglob *
+yaslglobnew(const char * pattern, size_t len, int flags);
+
+
+// Querying //
+int
+yaslglobmatch(const struct yaslglob * glob, const yastr str);
+
+int
+yaslglobmatchlen(const struct yaslglob * glob, const char * str, size_t len);
+
+
+// Freeing //
+void
+yaslglobfree(struct yaslglob * glob);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLLZ_H
+#define YASLLZ_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yasllz;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yasllz *
+yasllznew(void);
+
+
+// Querying //
+ptrdiff_t
+yasllzlen(const char * src, size_t len);
+
+int
+yasllzdone(const struct yasllz * lz);
+
+
+// Concatenation //
+yastr
+yaslcatlz(yastr dest, const void * src, size_t len);
+
+yastr
+yaslcatunlz(yastr dest, const char * src, size_t len);
+
+yastr
+yasllzcompress(struct yasllz * lz, yastr dest, const void * src, size_t len);
+
+yastr
+yasllzfinish(struct yasllz * lz, yastr dest);
+
+yastr
+yasllzdecompress(struct yasllz * lz, yastr dest, const void * src, size_t len);
+
+
+// Freeing //
+void
+yasllzfree(struct yasllz * lz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLMAP_H
+#define YASLMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yaslmap;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslmap *
+yaslmapnew(size_t valsize);
+
+
+// Querying //
+uint64_t
+yaslhash(const void * src, size_t len, uint64_t seed);
+
+void *
+yaslmapget(const struct yaslmap * map, const char * key, size_t len);
+
+size_t
+yaslmapcount(const struct yaslmap * map);
+
+int
+yaslmapnext(const struct yaslmap * map, size_t * iter, yastr * key, void ** value);
+
+
+// Modification //
+void *
+yaslmapput(struct yaslmap * map, const char * key, size_t len);
+
+int
+yaslmapdel(struct yaslmap * map, const char * key, size_t len);
+
+
+// Freeing //
+void
+yaslmapfree(struct yaslmap * map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLRAX_H
+#define YASLRAX_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yaslrax;
+struct yaslraxframe;
+
+/* An iterator over the keys of a tree in lexicographic order, see
+ * yaslraxseek(), yaslraxprefix() and yaslraxnext(). */
+struct yaslraxiter {
+	yastr key;                   /* the current key */
+	void * value;                /* and its value */
+	const struct yaslrax * rax;
+	struct yaslraxframe * stack;
+	size_t depth;
+	size_t size;
+};
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslrax *
+yaslraxnew(void);
+
+void
+yaslraxiterinit(struct yaslraxiter * it, const struct yaslrax * rax);
+
+
+// Querying //
+void **
+yaslraxget(const struct yaslrax * rax, const char * key, size_t len);
+
+size_t
+yaslraxcount(const struct yaslrax * rax);
+
+int
+yaslraxseek(struct yaslraxiter * it, const char * key, size_t len);
+
+int
+yaslraxprefix(struct yaslraxiter * it, const char * prefix, size_t len);
+
+int
+yaslraxnext(struct yaslraxiter * it);
+
+
+// Modification //
+void **
+yaslraxput(struct yaslrax * rax, const char * key, size_t len);
+
+int
+yaslraxdel(struct yaslrax * rax, const char * key, size_t len, void ** value);
+
+
+// Freeing //
+void
+yaslraxfree(struct yaslrax * rax);
+
+void
+yaslraxiterfree(struct yaslraxiter * it);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
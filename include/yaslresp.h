@@ -0,0 +1,69 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLRESP_H
+#define YASLRESP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The deepest nesting of aggregates that is parsed. */
+#define YASLRESP_DEPTH 32
+
+/* The state of a RESP parser, see yaslrespparse(). */
+struct yaslresp {
+	size_t pos;                  /* the offset of the next value */
+	size_t depth;                /* the number of aggregates being parsed */
+	uint32_t attrs;              /* which of them are attributes */
+	long long left[YASLRESP_DEPTH];  /* and the values left in each */
+};
+
+/* A value parsed by yaslrespparse(). Strings point into the parsed buffer. */
+struct yaslrespval {
+	char type;                   /* the type byte, such as '$' or '*' */
+	const char * str;            /* the bytes of strings, errors, doubles */
+	size_t len;                  /* and big numbers, and their length */
+	long long num;               /* integers, booleans, and the size of aggregates */
+};
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+void
+yaslrespinit(struct yaslresp * resp);
+
+
+// Querying //
+int
+yaslrespparse(struct yaslresp * resp, const char * buf, size_t len, struct yaslrespval * val);
+
+
+// Concatenation //
+yastr
+yaslcatresp(yastr dest, char type, const char * src, size_t len);
+
+yastr
+yaslcatrespint(yastr dest, char type, long long value);
+
+yastr
+yaslcatrespcmd(yastr dest, const yastr * argv, size_t argc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,68 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLSA_H
+#define YASLSA_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yaslsa;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslsa *
+yaslsanew(const char * text, size_t len);
+
+struct yaslsa *
+yaslsanewparallel(const char * text, size_t len, unsigned threads);
+
+struct yaslsa *
+yaslsaload(const char * text, size_t len, const void * src, size_t srclen);
+
+
+// Querying //
+size_t
+yaslsasearch(const struct yaslsa * sa, const char * pattern, size_t len, size_t * first);
+
+size_t
+yaslsacount(const struct yaslsa * sa, const char * pattern, size_t len);
+
+size_t
+yaslsalocate(const struct yaslsa * sa, const char * pattern, size_t len, size_t * offsets, size_t max);
+
+size_t
+yaslsaoffset(const struct yaslsa * sa, size_t rank);
+
+size_t
+yaslsalcp(const struct yaslsa * sa, size_t rank);
+
+
+// Concatenation //
+yastr
+yaslcatsa(yastr dest, const struct yaslsa * sa);
+
+
+// Freeing //
+void
+yaslsafree(struct yaslsa * sa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLSNAP_H
+#define YASLSNAP_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yaslsnap;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yaslsnap *
+yaslsnapload(const void * src, size_t len);
+
+struct yaslsnap *
+yaslsnapopen(const char * path);
+
+
+// Querying //
+size_t
+yaslsnapcount(const struct yaslsnap * snap);
+
+yastr
+yaslsnapget(const struct yaslsnap * snap, size_t index);
+
+
+// Concatenation //
+yastr
+yaslcatsnap(yastr dest, const yastr * strs, size_t count);
+
+
+// Freeing //
+void
+yaslsnapfree(struct yaslsnap * snap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,39 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLSORT_H
+#define YASLSORT_H
+
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * User API function prototypes
+ */
+
+// Modification //
+int
+yaslsort(yastr * argv, size_t count);
+
+int
+yaslsortparallel(yastr * argv, size_t count, unsigned threads);
+
+size_t
+yasluniq(yastr * argv, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#ifndef YASLTPL_H
+#define YASLTPL_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "yasl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct yasltpl;
+
+
+/**
+ * User API function prototypes
+ */
+
+// Initialization //
+struct yasltpl *
+yasltplnew(const char * fmt);
+
+
+// Concatenation //
+yastr
+yaslcatvtpl(yastr dest, const struct yasltpl * tpl, va_list ap);
+
+yastr
+yaslcattpl(yastr dest, const struct yasltpl * tpl, ...);
+
+
+// Freeing //
+void
+yasltplfree(struct yasltpl * tpl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
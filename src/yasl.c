@@ -10,12 +10,66 @@
 #include <assert.h>
 #include <ctype.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "yasl.h"
 
+/* The allocator of the memory of yasl strings, which can be replaced by
+ * defining these when compiling yasl, for example to use jemalloc, or to
+ * count allocations. Other memory, like the arrays returned by yaslsplitlen(),
+ * always comes from malloc(). */
+#ifndef YASL_MALLOC
+#define YASL_MALLOC malloc
+#endif
+#ifndef YASL_REALLOC
+#define YASL_REALLOC realloc
+#endif
+#ifndef YASL_FREE
+#define YASL_FREE free
+#endif
+
+/* This is where the inline fast paths of yasl.h fall back to. */
+#undef yaslMakeRoomFor
+#undef yaslIncrLen
+#undef yaslcatlen
+#undef yaslcat
+#undef yaslcatyasl
+#undef yaslcpylen
+
+/* Whether 'str' was defined with YASL_LITERAL() and must not be written to. */
+static inline int
+yaslisstatic(const yastr str) {
+	return (yaslheader(str)->flags & YASL_STATIC) != 0;
+}
+
+/* The number of bytes consumed from the front of the allocation of 'str'. */
+static inline size_t
+yaslhead(const yastr str) {
+	return yaslheader(str)->flags >> YASL_HEAD_SHIFT;
+}
+
+/* Move a string with a consumed prefix back to the start of its allocation,
+ * which turns the prefix into free space at the end. */
+static yastr
+yaslcompact(yastr str) {
+	struct yastrhdr * hdr = yaslheader(str), * base;
+	size_t head = yaslhead(str);
+
+	if (!head) { return str; }
+	base = (struct yastrhdr *)((char *)hdr - head);
+	memmove(base, hdr, sizeof(*hdr) + hdr->len + 1);
+	base->free += head;
+	base->flags &= ((size_t)1 << YASL_HEAD_SHIFT) - 1;
+	return base->buf;
+}
+
 
 // Initialization //
 
@@ -23,19 +77,16 @@
  * initialize it with. */
 yastr
 yaslnew(const void * init, size_t initlen) {
-	struct yastrhdr * hdr;
-
-	if (init) {
-		hdr = malloc(sizeof(struct yastrhdr) + initlen + 1);
-	} else {
-		hdr = calloc(sizeof(struct yastrhdr) + initlen + 1, 1);
-	}
+	struct yastrhdr * hdr = YASL_MALLOC(sizeof(struct yastrhdr) + initlen + 1);
 	if (!hdr) { return NULL; }
 
 	hdr->len = initlen;
 	hdr->free = 0;
+	hdr->flags = 0;
 	if (initlen && init) {
 		memcpy(hdr->buf, init, initlen);
+	} else if (initlen) {
+		memset(hdr->buf, 0, initlen);
 	}
 	hdr->buf[initlen] = '\0';
 	return (char*)hdr->buf;
@@ -55,21 +106,65 @@ yaslempty(void) {
 	return yaslnew("", 0);
 }
 
+/* Write the decimal digits of 'value' backwards, ending right before 'end',
+ * two digits at a time. Returns a pointer to the first digit. */
+static char *
+yaslull2str(char * end, unsigned long long value) {
+	static const char pairs[] =
+		"0001020304050607080910111213141516171819"
+		"2021222324252627282930313233343536373839"
+		"4041424344454647484950515253545556575859"
+		"6061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+
+	while (value >= 100) {
+		unsigned d = (unsigned)(value % 100) * 2;
+
+		value /= 100;
+		*--end = pairs[d + 1];
+		*--end = pairs[d];
+	}
+	if (value >= 10) {
+		*--end = pairs[value * 2 + 1];
+		*--end = pairs[value * 2];
+	} else {
+		*--end = (char)('0' + value);
+	}
+	return end;
+}
+
+/* Write 'value' in decimal, ending right before 'end'. Returns a pointer to the
+ * first character. */
+static char *
+yaslll2str(char * end, long long value) {
+	char * p;
+
+	if (value >= 0) { return yaslull2str(end, (unsigned long long)value); }
+	/* Negate in unsigned arithmetic, which is also defined for LLONG_MIN. */
+	p = yaslull2str(end, 0ULL - (unsigned long long)value);
+	*--p = '-';
+	return p;
+}
+
 /* Create a yasl string from a long long value. */
 yastr
 yaslfromlonglong(long long value) {
-	char buf[32], * p;
-	unsigned long long v;
+	char buf[21], * p;
+
+	p = yaslll2str(buf + sizeof(buf), value);
+	return yaslnew(p, (size_t)(buf + sizeof(buf) - p));
+}
+
+/* Initialize an empty string vector. Nothing is allocated until the first
+ * element is added. */
+void
+yaslvecinit(struct yaslvec * vec) {
+	if (!vec) { return; }
 
-	v = (unsigned long long)((value < 0) ? -value : value);
-	p = buf + 31; /* point to the last character */
-	do {
-		*p-- = '0' + (v%10);
-		v /= 10;
-	} while(v);
-	if (value < 0) { *p-- = '-'; }
-	p++;
-	return yaslnew(p, (size_t)(32 - (p - buf)));
+	vec->data = NULL;
+	vec->offsets = NULL;
+	vec->count = 0;
+	vec->slots = 0;
 }
 
 
@@ -89,13 +184,207 @@ yaslcmp(const yastr str1, const yastr str2) {
 	return cmp;
 }
 
+/* Return a pointer to the first occurrence of 'needle' in 'haystack', or NULL.
+ * Candidate positions are filtered 16 at a time by checking both the first and
+ * the last byte of the needle, so memcmp() only runs on likely matches. */
+static const char *
+yaslmemmem(const char * haystack, size_t hlen, const char * needle, size_t nlen) {
+	const char * p = haystack, * last;
+
+	if (nlen == 0) { return haystack; }
+	if (nlen > hlen) { return NULL; }
+	if (nlen == 1) { return memchr(haystack, needle[0], hlen); }
+
+	last = haystack + (hlen - nlen); /* last possible start of a match */
+#ifdef __SSE2__
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i final = _mm_set1_epi8(needle[nlen - 1]);
+	while (last - p >= 15) {
+		__m128i a = _mm_loadu_si128((const void *)p);
+		__m128i b = _mm_loadu_si128((const void *)(p + nlen - 1));
+		unsigned mask = (unsigned)_mm_movemask_epi8(
+		        _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, final)));
+		while (mask) {
+			unsigned bit = (unsigned)__builtin_ctz(mask);
+			if (memcmp(p + bit + 1, needle + 1, nlen - 2) == 0) { return p + bit; }
+			mask &= mask - 1;
+		}
+		p += 16;
+	}
+#endif
+	for (; p <= last; p++) {
+		p = memchr(p, needle[0], (size_t)(last - p) + 1);
+		if (!p) { return NULL; }
+		if (p[nlen - 1] == needle[nlen - 1] &&
+		    memcmp(p + 1, needle + 1, nlen - 2) == 0) {
+			return p;
+		}
+	}
+	return NULL;
+}
+
+/* Like yaslmemmem() but returns the last occurrence of 'needle'. */
+static const char *
+yaslmemrmem(const char * haystack, size_t hlen, const char * needle, size_t nlen) {
+	const char * p;
+
+	if (nlen == 0) { return haystack + hlen; }
+	if (nlen > hlen) { return NULL; }
+
+	p = haystack + (hlen - nlen); /* last possible start of a match */
+#ifdef __SSE2__
+	if (nlen > 1) {
+		const __m128i first = _mm_set1_epi8(needle[0]);
+		const __m128i final = _mm_set1_epi8(needle[nlen - 1]);
+		while (p - haystack >= 16) {
+			const char * base = p - 15;
+			__m128i a = _mm_loadu_si128((const void *)base);
+			__m128i b = _mm_loadu_si128((const void *)(base + nlen - 1));
+			unsigned mask = (unsigned)_mm_movemask_epi8(
+			        _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, final)));
+			while (mask) {
+				unsigned bit = 31 - (unsigned)__builtin_clz(mask);
+				if (memcmp(base + bit + 1, needle + 1, nlen - 2) == 0) { return base + bit; }
+				mask &= ~(1u << bit);
+			}
+			p -= 16;
+		}
+	}
+#endif
+	for (;; p--) {
+		if (p[0] == needle[0] && p[nlen - 1] == needle[nlen - 1] &&
+		    memcmp(p, needle, nlen) == 0) {
+			return p;
+		}
+		if (p == haystack) { return NULL; }
+	}
+}
+
+/* Return the index of the first occurrence of 'needle' in 'str', or -1 if it
+ * is not found. */
+ptrdiff_t
+yaslfind(const yastr str, const char * needle, size_t needlelen) {
+	if (!str || !needle) { return -1; }
+
+	const char * p = yaslmemmem(str, yasllen(str), needle, needlelen);
+	return p ? p - str : -1;
+}
+
+/* Return the index of the last occurrence of 'needle' in 'str', or -1 if it
+ * is not found. */
+ptrdiff_t
+yaslrfind(const yastr str, const char * needle, size_t needlelen) {
+	if (!str || !needle) { return -1; }
+
+	const char * p = yaslmemrmem(str, yasllen(str), needle, needlelen);
+	return p ? p - str : -1;
+}
+
+/* Return the length of the longest valid UTF-8 prefix of 'src', copying the
+ * validated bytes to 'dst' if it is not NULL. Runs of ASCII are checked (and
+ * copied) 16 bytes at a time. */
+static size_t
+yaslutf8prefix(const char * src, size_t len, char * dst) {
+	const unsigned char * s = (const unsigned char *)src;
+	size_t i = 0, n;
+
+	while (i < len) {
+#ifdef __SSE2__
+		while (len - i >= 16) {
+			__m128i v = _mm_loadu_si128((const void *)(s + i));
+			if (_mm_movemask_epi8(v)) { break; }
+			if (dst) { _mm_storeu_si128((void *)(dst + i), v); }
+			i += 16;
+		}
+		if (i == len) { break; }
+#endif
+		if (s[i] < 0x80) {
+			if (dst) { dst[i] = (char)s[i]; }
+			i++;
+			continue;
+		}
+
+		/* Well-formed sequences as listed in table 3-7 of the Unicode
+		 * standard, which excludes overlongs and surrogates. */
+		unsigned char lo = 0x80, hi = 0xBF;
+		if (s[i] >= 0xC2 && s[i] <= 0xDF) {
+			n = 2;
+		} else if (s[i] >= 0xE0 && s[i] <= 0xEF) {
+			n = 3;
+			if (s[i] == 0xE0) { lo = 0xA0; }
+			if (s[i] == 0xED) { hi = 0x9F; }
+		} else if (s[i] >= 0xF0 && s[i] <= 0xF4) {
+			n = 4;
+			if (s[i] == 0xF0) { lo = 0x90; }
+			if (s[i] == 0xF4) { hi = 0x8F; }
+		} else {
+			return i;
+		}
+		if (len - i < n || s[i + 1] < lo || s[i + 1] > hi) { return i; }
+		for (size_t j = 2; j < n; j++) {
+			if ((s[i + j] & 0xC0) != 0x80) { return i; }
+		}
+		if (dst) { memcpy(dst + i, s + i, n); }
+		i += n;
+	}
+	return len;
+}
+
+/* Return 1 if 'str' is well-formed UTF-8, and 0 otherwise. */
+int
+yaslutf8valid(const yastr str) {
+	if (!str) { return 0; }
+
+	return yaslutf8prefix(str, yasllen(str), NULL) == yasllen(str);
+}
+
+/* Return the number of code points in 'str', which is assumed to be valid
+ * UTF-8. Every byte that is not a continuation byte starts a code point. */
+size_t
+yaslutf8len(const yastr str) {
+	if (!str) { return 0; }
+
+	const signed char * s = (const signed char *)str;
+	size_t i = 0, count = 0, len = yasllen(str);
+
+#ifdef __SSE2__
+	/* Continuation bytes are 0x80-0xBF, which is -128 to -65 when signed. */
+	const __m128i cont = _mm_set1_epi8(-65);
+	for (; len - i >= 16; i += 16) {
+		__m128i v = _mm_loadu_si128((const void *)(s + i));
+		count += (size_t)__builtin_popcount(
+		        (unsigned)_mm_movemask_epi8(_mm_cmpgt_epi8(v, cont)));
+	}
+#endif
+	for (; i < len; i++) {
+		count += s[i] > -65;
+	}
+	return count;
+}
+
+/* Count the non-overlapping occurrences of 'needle' in 'str'. */
+size_t
+yaslcount(const yastr str, const char * needle, size_t needlelen) {
+	if (!str || !needle || needlelen == 0) { return 0; }
+
+	const char * p = str, * end = str + yasllen(str);
+	size_t count = 0;
+
+	while ((p = yaslmemmem(p, (size_t)(end - p), needle, needlelen))) {
+		count++;
+		p += needlelen;
+	}
+	return count;
+}
+
 
 // Modification //
 
 /* Modify a yasl string in-place to make it empty (zero length). */
 void
 yaslclear(yastr str) {
-	if (!str) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || yaslisstatic(str)) { return; }
 
 	struct yastrhdr * hdr = yaslheader(str);
 	hdr->free += hdr->len;
@@ -130,6 +419,7 @@ yaslgrowzero(yastr str, size_t len) {
 yastr
 yaslcpylen(yastr dest, const char * src, size_t len) {
 	if (!dest || !src) { return NULL; }
+	if (yaslisstatic(dest)) { return yaslnew(src, len); }
 
 	struct yastrhdr * hdr = yaslheader(dest);
 	size_t totlen = hdr->free + hdr->len;
@@ -185,12 +475,42 @@ yasljoinyasl(yastr * argv, int argc, const char * sep, size_t seplen) {
 	return join;
 }
 
+/* Like yasljoinyasl, but joins the elements of a string vector. The result is
+ * allocated once, with its exact length. */
+yastr
+yasljoinvec(const struct yaslvec * vec, const char * sep, size_t seplen) {
+	if (!vec || !sep) { return NULL; }
+
+	size_t total = 0;
+	yastr join;
+	char * p;
+
+	if (vec->count) {
+		/* The data holds every element plus its null terminator. */
+		total = yasllen(vec->data) - vec->count + seplen * (vec->count - 1);
+	}
+	join = yaslnew(NULL, total);
+	if (!join) { return NULL; }
+
+	p = join;
+	for (size_t j = 0; j < vec->count; j++) {
+		memcpy(p, yaslvecget(vec, j), yaslveclen(vec, j));
+		p += yaslveclen(vec, j);
+		if (j != vec->count - 1) {
+			memcpy(p, sep, seplen);
+			p += seplen;
+		}
+	}
+	return join;
+}
+
 /* Modify the string substituting all the occurrences of the set of
  * characters specified in the 'from' string to the corresponding character
  * in the 'to' array. */
 yastr
 yaslmapchars(yastr str, const char * from, const char * to, size_t setlen) {
 	if (!str || !from || !to) { return NULL; }
+	if (yaslisstatic(str) && !(str = yasldup(str))) { return NULL; }
 
 	for (size_t j = 0; j < yasllen(str); j++) {
 		for (size_t i = 0; i < setlen; i++) {
@@ -207,7 +527,8 @@ yaslmapchars(yastr str, const char * from, const char * to, size_t setlen) {
  * substring specified by the 'start' and 'end' indexes. */
 void
 yaslrange(yastr str, ptrdiff_t start, ptrdiff_t end) {
-	if (!str) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || yaslisstatic(str)) { return; }
 
 	struct yastrhdr * hdr = yaslheader(str);
 	size_t newlen, len = yasllen(str);
@@ -238,10 +559,109 @@ yaslrange(yastr str, ptrdiff_t start, ptrdiff_t end) {
 	hdr->len = newlen;
 }
 
+/* Remove the first 'len' bytes of the string, or all of it if it is shorter,
+ * in constant time. Instead of moving the rest of the string to the front, the
+ * start of the string moves forward together with its header. The consumed
+ * prefix is reclaimed once it is both larger than the rest of the string and
+ * YASL_MIN_COMPACT, or when the string needs room to grow. This makes a yasl
+ * string an efficient I/O buffer, appended to at the end and consumed at the
+ * front.
+ *
+ * The start of the string changes, so all references to the original string
+ * should be replaced with the one returned by this function. */
+yastr
+yaslconsume(yastr str, size_t len) {
+	if (!str) { return NULL; }
+
+	struct yastrhdr * hdr = yaslheader(str);
+	size_t newlen, free, flags, head;
+
+	if (len > hdr->len) { len = hdr->len; }
+	if (!len) { return str; }
+	if (yaslisstatic(str)) { return yaslnew(str + len, hdr->len - len); }
+	newlen = hdr->len - len;
+	free = hdr->free;
+	flags = hdr->flags + (len << YASL_HEAD_SHIFT);
+	head = flags >> YASL_HEAD_SHIFT;
+	hdr = (struct yastrhdr *)((char *)hdr + len);
+	hdr->len = newlen;
+	hdr->free = free;
+	hdr->flags = flags;
+	if (newlen == 0 || (head > newlen && head >= YASL_MIN_COMPACT)) {
+		return yaslcompact(hdr->buf);
+	}
+	return hdr->buf;
+}
+
+/* Replace all the non-overlapping occurrences of 'from' in 'str' with 'to'.
+ * When 'to' is not longer than 'from' the string is rewritten in place,
+ * otherwise the matches are counted first so that the string is grown at most
+ * once. */
+yastr
+yaslreplace(yastr str, const char * from, size_t fromlen, const char * to, size_t tolen) {
+	if (!str || !from || !to) { return NULL; }
+
+	struct yastrhdr * hdr;
+	size_t count, grow, len = yasllen(str);
+	const char * r, * m, * end;
+	char * w;
+
+	if (fromlen == 0) { return str; }
+	if (yaslisstatic(str) && !(str = yasldup(str))) { return NULL; }
+
+	if (tolen <= fromlen) {
+		r = str;
+		end = str + len;
+		w = str;
+		while ((m = yaslmemmem(r, (size_t)(end - r), from, fromlen))) {
+			if (w != r) { memmove(w, r, (size_t)(m - r)); }
+			w += m - r;
+			memcpy(w, to, tolen);
+			w += tolen;
+			r = m + fromlen;
+		}
+		if (r == str) { return str; }
+		memmove(w, r, (size_t)(end - r));
+		w += end - r;
+	} else {
+		count = yaslcount(str, from, fromlen);
+		if (count == 0) { return str; }
+		if (count > (SIZE_MAX - len) / (tolen - fromlen)) { return NULL; }
+		grow = count * (tolen - fromlen);
+		str = yaslMakeRoomFor(str, grow);
+		if (!str) { return NULL; }
+
+		/* Move the contents to the end of the grown string and rewrite them
+		 * forwards from the start. The write position never overtakes the read
+		 * position, as it starts 'grow' bytes behind it and only gains
+		 * 'tolen - fromlen' bytes per match. */
+		memmove(str + grow, str, len);
+		r = str + grow;
+		end = r + len;
+		w = str;
+		while (count--) {
+			m = yaslmemmem(r, (size_t)(end - r), from, fromlen);
+			memmove(w, r, (size_t)(m - r));
+			w += m - r;
+			memcpy(w, to, tolen);
+			w += tolen;
+			r = m + fromlen;
+		}
+		w += end - r;
+	}
+
+	hdr = yaslheader(str);
+	hdr->free = hdr->len + hdr->free - (size_t)(w - str);
+	hdr->len = (size_t)(w - str);
+	*w = '\0';
+	return str;
+}
+
 /* Remove all matching characters from the string */
 void
 yaslstrip(yastr str, const char * cset) {
-	if (!str || !cset) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || !cset || yaslisstatic(str)) { return; }
 
 	struct yastrhdr * hdr = yaslheader(str);
 	size_t i = 0, newlen = 0, len = yasllen(str);
@@ -264,10 +684,68 @@ yaslstrip(yastr str, const char * cset) {
 	hdr->len = newlen;
 }
 
+/* Like yaslrange(), but 'start' and 'end' are code point indexes in the UTF-8
+ * string 'str', so the result never ends in the middle of a sequence. */
+void
+yaslutf8range(yastr str, ptrdiff_t start, ptrdiff_t end) {
+	if (!str) { return; }
+
+	size_t i, cp, bstart, bend, len = yasllen(str);
+	ptrdiff_t count = (ptrdiff_t)yaslutf8len(str);
+
+	if (count == 0) { return; }
+	if (start < 0) {
+		start = count + start;
+		if (start < 0) { start = 0; }
+	}
+	if (end < 0) {
+		end = count + end;
+		if (end < 0) { end = 0; }
+	}
+	if (end >= count) { end = count - 1; }
+	if (start > end) {
+		yaslclear(str);
+		return;
+	}
+
+	/* Find the byte offsets where code point 'start' begins and where code
+	 * point 'end + 1' begins. */
+	bstart = bend = len;
+	for (i = 0, cp = 0; i < len; i++) {
+		if ((str[i] & 0xC0) == 0x80) { continue; }
+		if (cp == (size_t)start) { bstart = i; }
+		if (cp == (size_t)end + 1) {
+			bend = i;
+			break;
+		}
+		cp++;
+	}
+	yaslrange(str, (ptrdiff_t)bstart, (ptrdiff_t)bend - 1);
+}
+
+/* Truncate the UTF-8 string 'str' to at most 'maxlen' bytes without cutting a
+ * multi-byte sequence in half. */
+void
+yaslutf8trunc(yastr str, size_t maxlen) {
+	assert(!str || !yaslisstatic(str));
+	if (!str || yaslisstatic(str)) { return; }
+
+	struct yastrhdr * hdr = yaslheader(str);
+
+	if (hdr->len <= maxlen) { return; }
+	while (maxlen > 0 && (str[maxlen] & 0xC0) == 0x80) {
+		maxlen--;
+	}
+	hdr->free += hdr->len - maxlen;
+	hdr->len = maxlen;
+	str[maxlen] = '\0';
+}
+
 /* Apply tolower() to every character of the yasl string 's'. */
 void
 yasltolower(yastr str) {
-	if (!str) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || yaslisstatic(str)) { return; }
 
 	for (size_t j = 0; j < yasllen(str); j++) {
 		str[j] = (char)tolower(str[j]);
@@ -277,7 +755,8 @@ yasltolower(yastr str) {
 /* Apply toupper() to every character of the yasl string 's'. */
 void
 yasltoupper(yastr str) {
-	if (!str) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || yaslisstatic(str)) { return; }
 
 	for (size_t j = 0; j < yasllen(str); j++) {
 		str[j] = (char)toupper(str[j]);
@@ -288,7 +767,8 @@ yasltoupper(yastr str) {
  * contiguous characters found in 'cset', that is a null terminted C string. */
 void
 yasltrim(yastr str, const char * cset) {
-	if (!str || !cset) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || !cset || yaslisstatic(str)) { return; }
 
 	struct yastrhdr * hdr = yaslheader(str);
 	char * start, * end, * sp, * ep;
@@ -308,7 +788,8 @@ yasltrim(yastr str, const char * cset) {
 /* Set the yasl string length to the length as obtained with strlen(). */
 void
 yaslupdatelen(yastr str) {
-	if (!str) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || yaslisstatic(str)) { return; }
 
 	struct yastrhdr * hdr = yaslheader(str);
 	size_t reallen = strlen(str);
@@ -316,6 +797,102 @@ yaslupdatelen(yastr str) {
 	hdr->len = reallen;
 }
 
+/* Parse the next argument of '*line' as described for yaslsplitargs(),
+ * appending it to '*current' and moving '*line' past it. Returns 1 if an
+ * argument was parsed, 0 at the end of the line, and -1 on unbalanced quotes
+ * or out of memory, in which case '*current' is still a valid string. */
+static int
+yaslsplitargsnext(const char ** line, yastr * current) {
+	const char * p = *line;
+	int inq = 0;  /* set to 1 if we are in "quotes" */
+	int insq = 0; /* set to 1 if we are in 'single quotes' */
+	int done = 0;
+
+	/* skip blanks */
+	while(*p && isspace(*p)) { p++; }
+	if (!*p) { return 0; }
+
+	while(!done) {
+		yastr next = *current;
+
+		if (inq) {
+			if (*p == '\\' && *(p + 1) == 'x' &&
+			                         isxdigit(*(p + 2)) &&
+			                         isxdigit(*(p + 3)))
+			{
+				unsigned char byte;
+
+				byte = (unsigned char)((hex_digit_to_int(*(p + 2)) * 16) +
+				                        hex_digit_to_int(*(p + 3)));
+				next = yaslcatlen(*current, (char*)&byte, 1);
+				p += 3;
+			} else if (*p == '\\' && *(p + 1)) {
+				char c;
+
+				p++;
+				switch(*p) {
+				case 'n': c = '\n'; break;
+				case 'r': c = '\r'; break;
+				case 't': c = '\t'; break;
+				case 'b': c = '\b'; break;
+				case 'a': c = '\a'; break;
+				default: c = *p; break;
+				}
+				next = yaslcatlen(*current, &c, 1);
+			} else if (*p == '"') {
+				/* closing quote must be followed by a space or
+				 * nothing at all. */
+				if (*(p + 1) && !isspace(*(p + 1))) { return -1; }
+				done=1;
+			} else if (!*p) {
+				/* unterminated quotes */
+				return -1;
+			} else {
+				next = yaslcatlen(*current, p, 1);
+			}
+		} else if (insq) {
+			if (*p == '\\' && *(p + 1) == '\'') {
+				p++;
+				next = yaslcatlen(*current, "'", 1);
+			} else if (*p == '\'') {
+				/* closing quote must be followed by a space or
+				 * nothing at all. */
+				if (*(p + 1) && !isspace(*(p + 1))) { return -1; }
+				done=1;
+			} else if (!*p) {
+				/* unterminated quotes */
+				return -1;
+			} else {
+				next = yaslcatlen(*current, p, 1);
+			}
+		} else {
+			switch(*p) {
+			case ' ':
+			case '\n':
+			case '\r':
+			case '\t':
+			case '\0':
+				done=1;
+				break;
+			case '"':
+				inq=1;
+				break;
+			case '\'':
+				insq=1;
+				break;
+			default:
+				next = yaslcatlen(*current, p, 1);
+				break;
+			}
+		}
+		if (!next) { return -1; }
+		*current = next;
+		if (*p) { p++; }
+	}
+	*line = p;
+	return 1;
+}
+
 /* Split a line into arguments, where every argument can be in the
  * following programming-language REPL-alike form:
  *
@@ -328,107 +905,34 @@ yaslsplitargs(const char * line, int * argc) {
 	const char * p = line;
 	char * current = NULL;
 	char ** vector = NULL;
+	size_t slots = 0;
+	int ret;
 
 	*argc = 0;
 	while(1) {
-		/* skip blanks */
-		while(*p && isspace(*p)) { p++; }
-		if (*p) {
-			/* get a token */
-			int inq=0;  /* set to 1 if we are in "quotes" */
-			int insq=0; /* set to 1 if we are in 'single quotes' */
-			int done=0;
-
-			if (!current) { current = yaslempty(); }
-			while(!done) {
-				if (inq) {
-					if (*p == '\\' && *(p + 1) == 'x' &&
-					                         isxdigit(*(p + 2)) &&
-					                         isxdigit(*(p + 3)))
-					{
-						unsigned char byte;
-
-						byte = (unsigned char)((hex_digit_to_int(*(p + 2)) * 16) +
-						                        hex_digit_to_int(*(p + 3)));
-						current = yaslcatlen(current, (char*)&byte, 1);
-						p += 3;
-					} else if (*p == '\\' && *(p + 1)) {
-						char c;
-
-						p++;
-						switch(*p) {
-						case 'n': c = '\n'; break;
-						case 'r': c = '\r'; break;
-						case 't': c = '\t'; break;
-						case 'b': c = '\b'; break;
-						case 'a': c = '\a'; break;
-						default: c = *p; break;
-						}
-						current = yaslcatlen(current, &c, 1);
-					} else if (*p == '"') {
-						/* closing quote must be followed by a space or
-						 * nothing at all. */
-						if (*(p + 1) && !isspace(*(p + 1))) { goto err; }
-						done=1;
-					} else if (!*p) {
-						/* unterminated quotes */
-						goto err;
-					} else {
-						current = yaslcatlen(current, p, 1);
-					}
-				} else if (insq) {
-					if (*p == '\\' && *(p + 1) == '\'') {
-						p++;
-						current = yaslcatlen(current, "'", 1);
-					} else if (*p == '\'') {
-						/* closing quote must be followed by a space or
-						 * nothing at all. */
-						if (*(p + 1) && !isspace(*(p + 1))) { goto err; }
-						done=1;
-					} else if (!*p) {
-						/* unterminated quotes */
-						goto err;
-					} else {
-						current = yaslcatlen(current, p, 1);
-					}
-				} else {
-					switch(*p) {
-					case ' ':
-					case '\n':
-					case '\r':
-					case '\t':
-					case '\0':
-						done=1;
-						break;
-					case '"':
-						inq=1;
-						break;
-					case '\'':
-						insq=1;
-						break;
-					default:
-						current = yaslcatlen(current, p, 1);
-						break;
-					}
-				}
-				if (*p) { p++; }
-			}
-			/* add the token to the vector */
+		if (!current) { current = yaslempty(); }
+		ret = yaslsplitargsnext(&p, &current);
+		if (ret < 0) { goto err; }
+		if (ret == 0) {
+			yaslfree(current);
+			/* Even on empty input string return something not NULL. */
+			if (!vector) { vector = malloc(sizeof(void*)); }
+			return vector;
+		}
 
-			char ** tmp = realloc(vector, (unsigned long)((*argc) + 1) * (sizeof (char *)));
+		/* add the token to the vector */
+		if ((size_t)*argc == slots) {
+			slots = slots ? slots * 2 : 8;
+			char ** tmp = realloc(vector, slots * (sizeof (char *)));
 			if (!tmp) {
 				goto err;
 			}
 			vector = tmp;
-
-			vector[*argc] = current;
-			(*argc)++;
-			current = NULL;
-		} else {
-			/* Even on empty input string return something not NULL. */
-			if (!vector) { vector = malloc(sizeof(void*)); }
-			return vector;
 		}
+
+		vector[*argc] = current;
+		(*argc)++;
+		current = NULL;
 	}
 
 err:
@@ -495,6 +999,169 @@ cleanup:
 	}
 }
 
+/* Make sure that 'vec' has room for 'n' more elements, taking up 'bytes'
+ * bytes including their null terminators. */
+static int
+yaslvecreserve(struct yaslvec * vec, size_t n, size_t bytes) {
+	yastr tmp;
+
+	if (!vec->data) {
+		/* The first reservation is sized exactly. */
+		vec->data = yaslnew(NULL, bytes);
+		if (!vec->data) { return -1; }
+		yaslclear(vec->data);
+	} else {
+		tmp = yaslMakeRoomFor(vec->data, bytes);
+		if (!tmp) { return -1; }
+		vec->data = tmp;
+	}
+	if (vec->count + n + 1 > vec->slots) {
+		size_t slots = vec->slots * 2;
+		size_t * offsets;
+
+		if (slots < vec->count + n + 1) { slots = vec->count + n + 1; }
+		offsets = realloc(vec->offsets, slots * sizeof(size_t));
+		if (!offsets) { return -1; }
+		if (!vec->offsets) { offsets[0] = 0; }
+		vec->offsets = offsets;
+		vec->slots = slots;
+	}
+	return 0;
+}
+
+/* Like yaslsplitargs(), but appends the arguments to the string vector 'vec'.
+ * Returns 0 on success, or -1 on unbalanced quotes or out of memory, in which
+ * case 'vec' is left as it was. */
+int
+yaslsplitargsvec(struct yaslvec * vec, const char * line) {
+	if (!vec || !line) { return -1; }
+
+	const char * p = line;
+	size_t count = vec->count;
+	struct yastrhdr * hdr;
+	yastr data;
+	int ret;
+
+	while (1) {
+		if (yaslvecreserve(vec, 1, 1)) { break; }
+		ret = yaslsplitargsnext(&p, &vec->data);
+		if (ret == 0) { return 0; }
+		if (ret < 0) { break; }
+
+		/* The argument was parsed straight into the end of the data, which
+		 * may have used up the room for its null terminator. */
+		data = yaslMakeRoomFor(vec->data, 1);
+		if (!data) { break; }
+		vec->data = data;
+		vec->data[yasllen(vec->data)] = '\0';
+		yaslIncrLen(vec->data, 1);
+		vec->offsets[++vec->count] = yasllen(vec->data);
+	}
+
+	vec->count = count;
+	if (vec->data) {
+		hdr = yaslheader(vec->data);
+		hdr->free += hdr->len - vec->offsets[count];
+		hdr->len = vec->offsets[count];
+		vec->data[hdr->len] = '\0';
+	}
+	return -1;
+}
+
+/* Like yaslsplitlen(), but appends the tokens to the string vector 'vec'. The
+ * separators are counted first, so the vector grows at most once. Returns 0
+ * on success, or -1 on out of memory or if a zero-length separator was
+ * given. */
+int
+yaslsplitlenvec(struct yaslvec * vec, const char * str, size_t len, const char * sep, size_t seplen) {
+	if (!vec || !str || !sep || seplen < 1) { return -1; }
+
+	const char * p = str, * end = str + len, * m;
+	size_t n = 0;
+
+	if (len == 0) { return 0; }
+	while ((m = yaslmemmem(p, (size_t)(end - p), sep, seplen))) {
+		n++;
+		p = m + seplen;
+	}
+	if (yaslvecreserve(vec, n + 1, len - n * seplen + n + 1)) { return -1; }
+
+	p = str;
+	for (size_t j = 0; j <= n; j++) {
+		m = j < n ? yaslmemmem(p, (size_t)(end - p), sep, seplen) : end;
+		size_t off = yasllen(vec->data);
+		memcpy(vec->data + off, p, (size_t)(m - p));
+		vec->data[off + (size_t)(m - p)] = '\0';
+		yaslIncrLen(vec->data, (size_t)(m - p) + 1);
+		vec->offsets[++vec->count] = yasllen(vec->data);
+		p = m + seplen;
+	}
+	return 0;
+}
+
+/* Append a copy of the 'len' bytes at 'str' to the string vector 'vec'.
+ * Returns 0 on success and -1 on out of memory. */
+int
+yaslvecappend(struct yaslvec * vec, const void * str, size_t len) {
+	if (!vec || !str) { return -1; }
+
+	size_t off;
+
+	if (yaslvecreserve(vec, 1, len + 1)) { return -1; }
+	off = yasllen(vec->data);
+	memcpy(vec->data + off, str, len);
+	vec->data[off + len] = '\0';
+	yaslIncrLen(vec->data, len + 1);
+	vec->offsets[++vec->count] = off + len + 1;
+	return 0;
+}
+
+/* Append copies of an array of yasl strings, such as the result of
+ * yaslsplitlen(), to the string vector 'vec'. */
+int
+yaslvecfromarray(struct yaslvec * vec, yastr * argv, size_t count) {
+	if (!vec || !argv) { return -1; }
+
+	size_t bytes = count;
+
+	for (size_t j = 0; j < count; j++) {
+		bytes += yasllen(argv[j]);
+	}
+	if (yaslvecreserve(vec, count, bytes)) { return -1; }
+	for (size_t j = 0; j < count; j++) {
+		yaslvecappend(vec, argv[j], yasllen(argv[j]));
+	}
+	return 0;
+}
+
+/* Copy the elements of the string vector 'vec' into an array of 'vec->count'
+ * yasl strings, which should be freed with yaslfreesplitres(). */
+yastr *
+yaslvectoarray(const struct yaslvec * vec) {
+	if (!vec) { return NULL; }
+
+	yastr * tokens = malloc(sizeof(yastr) * (vec->count ? vec->count : 1));
+	if (!tokens) { return NULL; }
+
+	for (size_t j = 0; j < vec->count; j++) {
+		tokens[j] = yaslnew(yaslvecget(vec, j), yaslveclen(vec, j));
+		if (!tokens[j]) {
+			yaslfreesplitres(tokens, j);
+			return NULL;
+		}
+	}
+	return tokens;
+}
+
+/* Remove all elements from the string vector 'vec', keeping its memory. */
+void
+yaslvecclear(struct yaslvec * vec) {
+	if (!vec) { return; }
+
+	vec->count = 0;
+	if (vec->data) { yaslclear(vec->data); }
+}
+
 // Concatenation //
 
 /* Append the specified null termianted C string to the yasl string 'dest'. */
@@ -532,6 +1199,28 @@ yaslcatlen(yastr dest, const void * src, size_t len) {
 	return dest;
 }
 
+/* Append the decimal representation of 'value' to the yasl string 'dest'. */
+yastr
+yaslcatlonglong(yastr dest, long long value) {
+	if (!dest) { return NULL; }
+
+	char buf[21], * p;
+
+	p = yaslll2str(buf + sizeof(buf), value);
+	return yaslcatlen(dest, p, (size_t)(buf + sizeof(buf) - p));
+}
+
+/* Like yaslcatlonglong(), but for unsigned values. */
+yastr
+yaslcatulonglong(yastr dest, unsigned long long value) {
+	if (!dest) { return NULL; }
+
+	char buf[20], * p;
+
+	p = yaslull2str(buf + sizeof(buf), value);
+	return yaslcatlen(dest, p, (size_t)(buf + sizeof(buf) - p));
+}
+
 /* Append to the yasl string "dest" an escaped string representation where
  * all the non-printable characters (tested with isprint()) are turned into
  * escapes in the form "\n\r\a...." or "\x<hex-number>". */
@@ -564,6 +1253,666 @@ yaslcatrepr(yastr dest, const char * src, size_t len) {
 	return yaslcatlen(dest, "\"", 1);
 }
 
+/* Append the UTF-8 string 'src' of 'len' bytes to 'dest', validating it while
+ * it is copied. Returns NULL and leaves 'dest' unmodified if 'src' is not
+ * well-formed UTF-8. */
+yastr
+yaslcatutf8(yastr dest, const char * src, size_t len) {
+	if (!dest || !src) { return NULL; }
+
+	struct yastrhdr * hdr;
+	size_t curlen = yasllen(dest);
+
+	/* Static strings are never written to, so they always take the path
+	 * that copies them. */
+	if (!yaslisstatic(dest) && yaslavail(dest) >= len) {
+		if (yaslutf8prefix(src, len, dest + curlen) != len) {
+			dest[curlen] = '\0';
+			return NULL;
+		}
+	} else {
+		/* Validate before growing, so that a realloc() never happens for
+		 * input that is going to be rejected. */
+		if (yaslutf8prefix(src, len, NULL) != len) { return NULL; }
+		dest = yaslMakeRoomFor(dest, len);
+		if (!dest) { return NULL; }
+		memcpy(dest + curlen, src, len);
+	}
+	hdr = yaslheader(dest);
+	hdr->len = curlen + len;
+	hdr->free = hdr->free - len;
+	dest[curlen + len] = '\0';
+	return dest;
+}
+
+/* Digit values for the hex decoders, plus one so that zero means invalid. */
+static const unsigned char yaslhexvalues[256] = {
+	['0'] = 1,  ['1'] = 2,  ['2'] = 3,  ['3'] = 4,  ['4'] = 5,
+	['5'] = 6,  ['6'] = 7,  ['7'] = 8,  ['8'] = 9,  ['9'] = 10,
+	['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+	['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+};
+
+static const char yaslbase64std[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char yaslbase64url[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+/* Reverse lookup tables for the base64 alphabets above, 255 means invalid. */
+static const unsigned char yaslunbase64stdvalues[256] = {
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255, 255,  63,
+	 52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255, 255, 255, 255,
+	255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+	 15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255, 255,
+	255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+	 41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+static const unsigned char yaslunbase64urlvalues[256] = {
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  62, 255, 255,
+	 52,  53,  54,  55,  56,  57,  58,  59,  60,  61, 255, 255, 255, 255, 255, 255,
+	255,   0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,
+	 15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25, 255, 255, 255, 255,  63,
+	255,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,
+	 41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+/* A decoder writes the decoded form of 'src' to 'dst' and returns its length,
+ * or returns -1 if 'src' is malformed. When 'dst' is NULL it only validates. */
+typedef ptrdiff_t (*yasldecoder)(const char * src, size_t len, char * dst);
+
+/* Append the output of 'decode' to 'dest', which is at most 'maxlen' bytes.
+ * The input is decoded straight into the free space of 'dest' if there is
+ * room, otherwise, or if 'dest' is static, it is validated before the string
+ * is grown or copied, so that 'dest' is left untouched if NULL is returned. */
+static yastr
+yaslcatdecoded(yastr dest, const char * src, size_t len, size_t maxlen, yasldecoder decode) {
+	if (!dest || !src) { return NULL; }
+
+	size_t curlen = yasllen(dest);
+	ptrdiff_t outlen;
+
+	if (yaslisstatic(dest) || yaslavail(dest) < maxlen) {
+		if (decode(src, len, NULL) < 0) { return NULL; }
+		dest = yaslMakeRoomFor(dest, maxlen);
+		if (!dest) { return NULL; }
+	}
+	outlen = decode(src, len, dest + curlen);
+	if (outlen < 0) {
+		dest[curlen] = '\0';
+		return NULL;
+	}
+	yaslIncrLen(dest, (size_t)outlen);
+	return dest;
+}
+
+/* Append the lowercase hex representation of the 'len' bytes at 'src' to the
+ * yasl string 'dest'. */
+yastr
+yaslcathex(yastr dest, const void * src, size_t len) {
+	if (!dest || !src) { return NULL; }
+
+	const unsigned char * s = src;
+	size_t i = 0, curlen = yasllen(dest);
+	char * p;
+
+	if (len > SIZE_MAX / 2) { return NULL; }
+	dest = yaslMakeRoomFor(dest, len * 2);
+	if (!dest) { return NULL; }
+	p = dest + curlen;
+#ifdef __SSE2__
+	const __m128i nibble = _mm_set1_epi8(0x0f), nine = _mm_set1_epi8(9);
+	const __m128i zero = _mm_set1_epi8('0'), gap = _mm_set1_epi8('a' - '0' - 10);
+	for (; len - i >= 16; i += 16, p += 32) {
+		__m128i v = _mm_loadu_si128((const void *)(s + i));
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+		__m128i lo = _mm_and_si128(v, nibble);
+		__m128i a = _mm_unpacklo_epi8(hi, lo), b = _mm_unpackhi_epi8(hi, lo);
+		a = _mm_add_epi8(_mm_add_epi8(a, zero), _mm_and_si128(_mm_cmpgt_epi8(a, nine), gap));
+		b = _mm_add_epi8(_mm_add_epi8(b, zero), _mm_and_si128(_mm_cmpgt_epi8(b, nine), gap));
+		_mm_storeu_si128((void *)p, a);
+		_mm_storeu_si128((void *)(p + 16), b);
+	}
+#endif
+	for (; i < len; i++) {
+		*p++ = "0123456789abcdef"[s[i] >> 4];
+		*p++ = "0123456789abcdef"[s[i] & 0x0f];
+	}
+	yaslIncrLen(dest, len * 2);
+	return dest;
+}
+
+#ifdef __SSE2__
+/* Convert 16 hex digits to their values, clearing '*valid' if any of them is
+ * not a hex digit. */
+static inline __m128i
+yaslhexnibbles(__m128i v, int * valid) {
+	const __m128i one = _mm_set1_epi8(-1);
+	__m128i d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+	__m128i l = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	__m128i isdigit = _mm_and_si128(_mm_cmpgt_epi8(d, one),
+	                                _mm_cmplt_epi8(d, _mm_set1_epi8(10)));
+	__m128i isalpha = _mm_and_si128(_mm_cmpgt_epi8(l, one),
+	                                _mm_cmplt_epi8(l, _mm_set1_epi8(6)));
+
+	if (_mm_movemask_epi8(_mm_or_si128(isdigit, isalpha)) != 0xFFFF) { *valid = 0; }
+	return _mm_or_si128(_mm_and_si128(isdigit, d),
+	                    _mm_and_si128(isalpha, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+/* Combine pairs of nibbles into bytes, leaving each in the low half of a
+ * 16-bit lane. */
+static inline __m128i
+yaslhexpairs(__m128i v) {
+	return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x00ff)), 4),
+	                    _mm_srli_epi16(v, 8));
+}
+#endif
+
+static ptrdiff_t
+yaslunhex(const char * src, size_t len, char * dst) {
+	const unsigned char * s = (const unsigned char *)src;
+	size_t i = 0, o = 0;
+	unsigned hi, lo;
+
+	if (len % 2) { return -1; }
+#ifdef __SSE2__
+	for (; len - i >= 32; i += 32, o += 16) {
+		int valid = 1;
+		__m128i a = yaslhexnibbles(_mm_loadu_si128((const void *)(s + i)), &valid);
+		__m128i b = yaslhexnibbles(_mm_loadu_si128((const void *)(s + i + 16)), &valid);
+		if (!valid) { return -1; }
+		if (dst) {
+			_mm_storeu_si128((void *)(dst + o),
+			                 _mm_packus_epi16(yaslhexpairs(a), yaslhexpairs(b)));
+		}
+	}
+#endif
+	for (; i < len; i += 2, o++) {
+		hi = yaslhexvalues[s[i]];
+		lo = yaslhexvalues[s[i + 1]];
+		if (!hi || !lo) { return -1; }
+		if (dst) { dst[o] = (char)(((hi - 1) << 4) | (lo - 1)); }
+	}
+	return (ptrdiff_t)o;
+}
+
+/* Append the bytes encoded by the hex string 'src' of 'len' bytes to 'dest'.
+ * Returns NULL, leaving 'dest' unmodified, if 'src' is not valid hex. */
+yastr
+yaslcatunhex(yastr dest, const char * src, size_t len) {
+	return yaslcatdecoded(dest, src, len, len / 2, yaslunhex);
+}
+
+static yastr
+yaslcatb64(yastr dest, const unsigned char * s, size_t len, const char * alphabet, int pad) {
+	size_t i = 0, outlen, curlen = yasllen(dest);
+	uint32_t v;
+	char * p;
+
+	if (len / 3 >= SIZE_MAX / 4 - 1) { return NULL; }
+	outlen = (len / 3) * 4;
+	if (len % 3) { outlen += pad ? 4 : len % 3 + 1; }
+	dest = yaslMakeRoomFor(dest, outlen);
+	if (!dest) { return NULL; }
+	p = dest + curlen;
+
+	for (; len - i >= 3; i += 3, p += 4) {
+		v = (uint32_t)s[i] << 16 | (uint32_t)s[i + 1] << 8 | s[i + 2];
+		p[0] = alphabet[v >> 18];
+		p[1] = alphabet[(v >> 12) & 0x3f];
+		p[2] = alphabet[(v >> 6) & 0x3f];
+		p[3] = alphabet[v & 0x3f];
+	}
+	if (len - i) {
+		v = (uint32_t)s[i] << 16;
+		if (len - i == 2) { v |= (uint32_t)s[i + 1] << 8; }
+		*p++ = alphabet[v >> 18];
+		*p++ = alphabet[(v >> 12) & 0x3f];
+		if (len - i == 2) {
+			*p++ = alphabet[(v >> 6) & 0x3f];
+		} else if (pad) {
+			*p++ = '=';
+		}
+		if (pad) { *p++ = '='; }
+	}
+	yaslIncrLen(dest, outlen);
+	return dest;
+}
+
+/* Append the standard, padded base64 encoding of the 'len' bytes at 'src' to
+ * the yasl string 'dest'. */
+yastr
+yaslcatbase64(yastr dest, const void * src, size_t len) {
+	if (!dest || !src) { return NULL; }
+
+	return yaslcatb64(dest, src, len, yaslbase64std, 1);
+}
+
+/* Like yaslcatbase64(), but uses the URL and filename safe alphabet and leaves
+ * out the padding. */
+yastr
+yaslcatbase64url(yastr dest, const void * src, size_t len) {
+	if (!dest || !src) { return NULL; }
+
+	return yaslcatb64(dest, src, len, yaslbase64url, 0);
+}
+
+static ptrdiff_t
+yaslunb64(const char * src, size_t len, char * dst, const unsigned char * values, int padded) {
+	const unsigned char * s = (const unsigned char *)src;
+	size_t i = 0, o = 0;
+	uint32_t a, b, c, d;
+
+	/* Standard base64 must be padded, the URL safe variant may be. */
+	if (padded && len % 4) { return -1; }
+	if (len % 4 == 0 && len && s[len - 1] == '=') {
+		len--;
+		if (s[len - 1] == '=') { len--; }
+	}
+	if (len % 4 == 1) { return -1; }
+
+	for (; len - i >= 4; i += 4, o += 3) {
+		a = values[s[i]];
+		b = values[s[i + 1]];
+		c = values[s[i + 2]];
+		d = values[s[i + 3]];
+		if ((a | b | c | d) & 0x80) { return -1; }
+		if (dst) {
+			uint32_t v = a << 18 | b << 12 | c << 6 | d;
+			dst[o] = (char)(v >> 16);
+			dst[o + 1] = (char)(v >> 8);
+			dst[o + 2] = (char)v;
+		}
+	}
+	if (len - i) {
+		a = values[s[i]];
+		b = values[s[i + 1]];
+		c = len - i == 3 ? values[s[i + 2]] : 0;
+		if ((a | b | c) & 0x80) { return -1; }
+		if (dst) { dst[o] = (char)(a << 2 | b >> 4); }
+		o++;
+		if (len - i == 3) {
+			if (dst) { dst[o] = (char)(b << 4 | c >> 2); }
+			o++;
+		}
+	}
+	return (ptrdiff_t)o;
+}
+
+static ptrdiff_t
+yaslunbase64std(const char * src, size_t len, char * dst) {
+	return yaslunb64(src, len, dst, yaslunbase64stdvalues, 1);
+}
+
+static ptrdiff_t
+yaslunbase64url(const char * src, size_t len, char * dst) {
+	return yaslunb64(src, len, dst, yaslunbase64urlvalues, 0);
+}
+
+/* Append the bytes encoded by the standard base64 string 'src' to 'dest'.
+ * Returns NULL, leaving 'dest' unmodified, if 'src' is not valid base64. */
+yastr
+yaslcatunbase64(yastr dest, const char * src, size_t len) {
+	return yaslcatdecoded(dest, src, len, len / 4 * 3 + 3, yaslunbase64std);
+}
+
+/* Like yaslcatunbase64(), but for the URL and filename safe alphabet, with
+ * optional padding. */
+yastr
+yaslcatunbase64url(yastr dest, const char * src, size_t len) {
+	return yaslcatdecoded(dest, src, len, len / 4 * 3 + 3, yaslunbase64url);
+}
+
+/* Return true if 'c' is an unreserved character in RFC 3986. */
+static inline int
+yaslisunreserved(unsigned char c) {
+	return (unsigned)((c | 0x20) - 'a') < 26 || (unsigned)(c - '0') < 10 ||
+	       c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+#ifdef __SSE2__
+/* Return a bitmask with a bit set for every unreserved byte in 'v'. */
+static inline unsigned
+yaslunreservedmask(__m128i v) {
+	__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	__m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+	                              _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+	                              _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	__m128i mark = _mm_or_si128(
+	        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')), _mm_cmpeq_epi8(v, _mm_set1_epi8('.'))),
+	        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('~'))));
+
+	return (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), mark));
+}
+#endif
+
+/* Append the percent-encoding (RFC 3986) of the 'len' bytes at 'src' to the
+ * yasl string 'dest'. Everything but the unreserved characters is escaped. */
+yastr
+yaslcatpercent(yastr dest, const void * src, size_t len) {
+	if (!dest || !src) { return NULL; }
+
+	const unsigned char * s = src;
+	size_t i = 0, escapes = 0, curlen = yasllen(dest);
+	char * p;
+
+	/* Count the escapes first so that the output is sized exactly. */
+#ifdef __SSE2__
+	for (; len - i >= 16; i += 16) {
+		unsigned mask = yaslunreservedmask(_mm_loadu_si128((const void *)(s + i)));
+		escapes += (size_t)__builtin_popcount(~mask & 0xFFFF);
+	}
+#endif
+	for (; i < len; i++) {
+		escapes += !yaslisunreserved(s[i]);
+	}
+	dest = yaslMakeRoomFor(dest, len + escapes * 2);
+	if (!dest) { return NULL; }
+
+	p = dest + curlen;
+	i = 0;
+#ifdef __SSE2__
+	for (; len - i >= 16; i += 16) {
+		__m128i v = _mm_loadu_si128((const void *)(s + i));
+		if (yaslunreservedmask(v) == 0xFFFF) {
+			_mm_storeu_si128((void *)p, v);
+			p += 16;
+			continue;
+		}
+		for (size_t j = i; j < i + 16; j++) {
+			if (yaslisunreserved(s[j])) {
+				*p++ = (char)s[j];
+			} else {
+				*p++ = '%';
+				*p++ = "0123456789ABCDEF"[s[j] >> 4];
+				*p++ = "0123456789ABCDEF"[s[j] & 0x0f];
+			}
+		}
+	}
+#endif
+	for (; i < len; i++) {
+		if (yaslisunreserved(s[i])) {
+			*p++ = (char)s[i];
+		} else {
+			*p++ = '%';
+			*p++ = "0123456789ABCDEF"[s[i] >> 4];
+			*p++ = "0123456789ABCDEF"[s[i] & 0x0f];
+		}
+	}
+	yaslIncrLen(dest, len + escapes * 2);
+	return dest;
+}
+
+static ptrdiff_t
+yaslunpercent(const char * src, size_t len, char * dst) {
+	const char * p = src, * end = src + len, * pct;
+	size_t o = 0;
+	unsigned hi, lo;
+
+	while ((pct = memchr(p, '%', (size_t)(end - p)))) {
+		if (dst) { memcpy(dst + o, p, (size_t)(pct - p)); }
+		o += (size_t)(pct - p);
+		if (end - pct < 3) { return -1; }
+		hi = yaslhexvalues[(unsigned char)pct[1]];
+		lo = yaslhexvalues[(unsigned char)pct[2]];
+		if (!hi || !lo) { return -1; }
+		if (dst) { dst[o] = (char)(((hi - 1) << 4) | (lo - 1)); }
+		o++;
+		p = pct + 3;
+	}
+	if (dst) { memcpy(dst + o, p, (size_t)(end - p)); }
+	return (ptrdiff_t)(o + (size_t)(end - p));
+}
+
+/* Append the bytes encoded by the percent-encoded string 'src' to 'dest'.
+ * Returns NULL, leaving 'dest' unmodified, if 'src' contains a '%' that is not
+ * followed by two hex digits. */
+yastr
+yaslcatunpercent(yastr dest, const char * src, size_t len) {
+	return yaslcatdecoded(dest, src, len, len, yaslunpercent);
+}
+
+/* The escape character used for each byte in a JSON string, 'u' for bytes
+ * that need a \u00XX escape and zero for bytes that are copied as they are. */
+static const char yasljsonescapes[256] = {
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+	'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+	['"'] = '"', ['\\'] = '\\',
+};
+
+/* Return the length of the prefix of 's' that can be copied into a JSON
+ * string as it is. With 'ascii' set, bytes above 0x7F also end the prefix. */
+static size_t
+yasljsonclean(const unsigned char * s, size_t len, int ascii) {
+	size_t i = 0;
+
+#ifdef __SSE2__
+	const __m128i ctrl = _mm_set1_epi8(0x1F), zero = _mm_setzero_si128();
+	const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\');
+	for (; len - i >= 16; i += 16) {
+		__m128i v = _mm_loadu_si128((const void *)(s + i));
+		__m128i special = _mm_or_si128(_mm_cmpeq_epi8(_mm_subs_epu8(v, ctrl), zero),
+		        _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)));
+		unsigned mask = (unsigned)_mm_movemask_epi8(special);
+		if (ascii) { mask |= (unsigned)_mm_movemask_epi8(v); }
+		if (mask) { return i + (unsigned)__builtin_ctz(mask); }
+	}
+#endif
+	for (; i < len; i++) {
+		if (yasljsonescapes[s[i]] || (ascii && s[i] >= 0x80)) { break; }
+	}
+	return i;
+}
+
+/* Write a \uXXXX escape for 'cp' to 'p' and return the position after it. */
+static char *
+yasljsonu(char * p, unsigned cp) {
+	p[0] = '\\';
+	p[1] = 'u';
+	p[2] = "0123456789abcdef"[(cp >> 12) & 0x0f];
+	p[3] = "0123456789abcdef"[(cp >> 8) & 0x0f];
+	p[4] = "0123456789abcdef"[(cp >> 4) & 0x0f];
+	p[5] = "0123456789abcdef"[cp & 0x0f];
+	return p + 6;
+}
+
+/* Append 'src' to the yasl string 'dest' as a quoted JSON string. Quotes,
+ * backslashes and control characters are escaped. If 'ascii' is non-zero, all
+ * non-ASCII UTF-8 sequences are escaped with \u as well, and bytes that are
+ * not valid UTF-8 are replaced with U+FFFD. Clean runs are found 16 bytes at a
+ * time and copied in bulk. */
+yastr
+yaslcatjson(yastr dest, const char * src, size_t len, int ascii) {
+	if (!dest || !src) { return NULL; }
+
+	const unsigned char * s = (const unsigned char *)src;
+	size_t run, n, i = 0;
+	unsigned cp;
+	char * p;
+
+	/* Most strings need few escapes, so reserve for the unescaped case. */
+	dest = yaslMakeRoomFor(dest, len + 2);
+	if (!dest) { return NULL; }
+	dest[yasllen(dest)] = '"';
+	yaslIncrLen(dest, 1);
+
+	while (i < len) {
+		run = yasljsonclean(s + i, len - i, ascii);
+		/* Room for the run and for the longest escape that can follow it. */
+		dest = yaslMakeRoomFor(dest, run + 12);
+		if (!dest) { return NULL; }
+		p = dest + yasllen(dest);
+		memcpy(p, s + i, run);
+		p += run;
+		i += run;
+
+		if (i < len) {
+			if (s[i] < 0x80) {
+				*p++ = '\\';
+				if (yasljsonescapes[s[i]] == 'u') {
+					p = yasljsonu(p - 1, s[i]);
+				} else {
+					*p++ = yasljsonescapes[s[i]];
+				}
+				i++;
+			} else {
+				n = yaslutf8prefix(src + i, len - i > 4 ? 4 : len - i, NULL);
+				if (n == 0) {
+					cp = 0xFFFD;
+					n = 1;
+				} else {
+					/* yaslutf8prefix() stops at a sequence boundary, so
+					 * step back to the start of the first sequence. */
+					n = s[i] >= 0xF0 ? 4 : s[i] >= 0xE0 ? 3 : 2;
+					cp = s[i] & (0x7F >> n);
+					for (size_t j = 1; j < n; j++) {
+						cp = (cp << 6) | (s[i + j] & 0x3F);
+					}
+				}
+				if (cp >= 0x10000) {
+					cp -= 0x10000;
+					p = yasljsonu(p, 0xD800 | (cp >> 10));
+					p = yasljsonu(p, 0xDC00 | (cp & 0x3FF));
+				} else {
+					p = yasljsonu(p, cp);
+				}
+				i += n;
+			}
+		}
+		yaslIncrLen(dest, (size_t)(p - (dest + yasllen(dest))));
+	}
+
+	dest = yaslMakeRoomFor(dest, 1);
+	if (!dest) { return NULL; }
+	dest[yasllen(dest)] = '"';
+	yaslIncrLen(dest, 1);
+	return dest;
+}
+
+/* Parse four hex digits at 's', returning -1 if they are not all hex. */
+static long
+yasljsonhex4(const char * s) {
+	long v = 0;
+	for (int i = 0; i < 4; i++) {
+		unsigned d = yaslhexvalues[(unsigned char)s[i]];
+		if (!d) { return -1; }
+		v = (v << 4) | (long)(d - 1);
+	}
+	return v;
+}
+
+/* Write the UTF-8 encoding of 'cp' to 'p', if it is not NULL, and return the
+ * number of bytes it takes. */
+static size_t
+yaslutf8encode(char * p, unsigned long cp) {
+	if (cp < 0x80) {
+		if (p) { p[0] = (char)cp; }
+		return 1;
+	} else if (cp < 0x800) {
+		if (p) {
+			p[0] = (char)(0xC0 | (cp >> 6));
+			p[1] = (char)(0x80 | (cp & 0x3F));
+		}
+		return 2;
+	} else if (cp < 0x10000) {
+		if (p) {
+			p[0] = (char)(0xE0 | (cp >> 12));
+			p[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+			p[2] = (char)(0x80 | (cp & 0x3F));
+		}
+		return 3;
+	}
+	if (p) {
+		p[0] = (char)(0xF0 | (cp >> 18));
+		p[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		p[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		p[3] = (char)(0x80 | (cp & 0x3F));
+	}
+	return 4;
+}
+
+static ptrdiff_t
+yaslunjson(const char * src, size_t len, char * dst) {
+	const unsigned char * s = (const unsigned char *)src;
+	size_t run, i = 1, o = 0;
+	long cp, lo;
+	char c;
+
+	if (len < 2 || s[0] != '"' || s[len - 1] != '"') { return -1; }
+	len--;
+	while (i < len) {
+		/* Copy everything up to the next quote, backslash or control
+		 * character in bulk. */
+		run = yasljsonclean(s + i, len - i, 0);
+		if (dst) { memcpy(dst + o, s + i, run); }
+		o += run;
+		i += run;
+		if (i == len) { break; }
+		if (s[i] != '\\' || len - i < 2) { return -1; }
+
+		switch (s[i + 1]) {
+		case '"':  c = '"';  break;
+		case '\\': c = '\\'; break;
+		case '/':  c = '/';  break;
+		case 'b':  c = '\b'; break;
+		case 'f':  c = '\f'; break;
+		case 'n':  c = '\n'; break;
+		case 'r':  c = '\r'; break;
+		case 't':  c = '\t'; break;
+		case 'u':
+			if (len - i < 6 || (cp = yasljsonhex4(src + i + 2)) < 0) { return -1; }
+			i += 6;
+			if (cp >= 0xD800 && cp <= 0xDBFF && len - i >= 6 && s[i] == '\\' &&
+			    s[i + 1] == 'u' && (lo = yasljsonhex4(src + i + 2)) >= 0xDC00 &&
+			    lo <= 0xDFFF) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+				i += 6;
+			} else if (cp >= 0xD800 && cp <= 0xDFFF) {
+				/* Unpaired surrogates cannot be encoded as UTF-8. */
+				cp = 0xFFFD;
+			}
+			o += yaslutf8encode(dst ? dst + o : NULL, (unsigned long)cp);
+			continue;
+		default:
+			return -1;
+		}
+		if (dst) { dst[o] = c; }
+		o++;
+		i += 2;
+	}
+	return (ptrdiff_t)o;
+}
+
+/* Append the contents of the quoted JSON string 'src' to 'dest', decoding all
+ * escapes, including \uXXXX surrogate pairs. Returns NULL, leaving 'dest'
+ * unmodified, if 'src' is not a valid JSON string. */
+yastr
+yaslcatunjson(yastr dest, const char * src, size_t len) {
+	return yaslcatdecoded(dest, src, len, len, yaslunjson);
+}
+
 /* Like yaslcatpritf() but gets va_list instead of being variadic. */
 #pragma GCC diagnostic ignored "-Wformat-nonliteral"
 yastr
@@ -614,8 +1963,8 @@ yaslcatprintf(yastr str, const char * fmt, ...) {
 /* Free a yasl string. No operation is performed if 's' is NULL. */
 void
 yaslfree(yastr str) {
-	if (str) {
-		free(yaslheader(str));
+	if (str && !yaslisstatic(str)) {
+		YASL_FREE((char *)yaslheader(str) - yaslhead(str));
 	}
 }
 
@@ -630,15 +1979,26 @@ yaslfreesplitres(yastr * tokens, size_t count) {
 	free(tokens);
 }
 
+/* Free the memory held by the string vector 'vec', leaving it empty. */
+void
+yaslvecfree(struct yaslvec * vec) {
+	if (!vec) { return; }
+
+	yaslfree(vec->data);
+	free(vec->offsets);
+	yaslvecinit(vec);
+}
+
 
 // Low-level functions //
 
 /* Return the total size of the allocation of the specifed yasl string,
  * including:
- * 1) The yasl header before the pointer.
- * 2) The string.
- * 3) The free buffer at the end if any.
- * 4) The implicit null term.
+ * 1) The prefix consumed by yaslconsume() if any.
+ * 2) The yasl header before the pointer.
+ * 3) The string.
+ * 4) The free buffer at the end if any.
+ * 5) The implicit null term.
  */
 size_t
 yaslAllocSize(yastr str) {
@@ -646,7 +2006,7 @@ yaslAllocSize(yastr str) {
 
 	struct yastrhdr * hdr = yaslheader(str);
 
-	return sizeof(*hdr) + hdr->len + hdr->free + 1;
+	return yaslhead(str) + sizeof(*hdr) + hdr->len + hdr->free + 1;
 }
 
 /* Increment the yasl string length and decrements the left free space at the
@@ -654,7 +2014,8 @@ yaslAllocSize(yastr str) {
  * of the string. */
 void
 yaslIncrLen(yastr str, size_t incr) {
-	if (!str) { return; }
+	assert(!str || !yaslisstatic(str));
+	if (!str || yaslisstatic(str)) { return; }
 
 	struct yastrhdr * hdr = yaslheader(str);
 
@@ -675,7 +2036,12 @@ yaslMakeRoomFor(yastr str, size_t addlen) {
 	size_t free = yaslavail(str);
 	size_t len, newlen;
 
-	if (free >= addlen) { return str; }
+	if (free >= addlen && !yaslisstatic(str)) { return str; }
+	if (yaslhead(str)) {
+		/* A consumed prefix may already be enough room. */
+		str = yaslcompact(str);
+		if (yaslavail(str) >= addlen) { return str; }
+	}
 	len = yasllen(str);
 	hdr = yaslheader(str);
 	newlen = (len + addlen);
@@ -684,8 +2050,17 @@ yaslMakeRoomFor(yastr str, size_t addlen) {
 	} else {
 		newlen += YASL_MAX_PREALLOC;
 	}
-	newhdr = realloc(hdr, sizeof(struct yastrhdr) + newlen + 1);
-	if (!newhdr) { return NULL; }
+	if (yaslisstatic(str)) {
+		/* Static strings are copied instead of written to. */
+		newhdr = YASL_MALLOC(sizeof(struct yastrhdr) + newlen + 1);
+		if (!newhdr) { return NULL; }
+		memcpy(newhdr->buf, str, len + 1);
+		newhdr->len = len;
+		newhdr->flags = 0;
+	} else {
+		newhdr = YASL_REALLOC(hdr, sizeof(struct yastrhdr) + newlen + 1);
+		if (!newhdr) { return NULL; }
+	}
 
 	newhdr->free = newlen - len;
 	return newhdr->buf;
@@ -696,11 +2071,12 @@ yaslMakeRoomFor(yastr str, size_t addlen) {
  * will require a reallocation. */
 yastr
 yaslRemoveFreeSpace(yastr str) {
-	if (!str) { return NULL; }
+	if (!str || yaslisstatic(str)) { return str; }
 
+	str = yaslcompact(str);
 	struct yastrhdr * hdr = yaslheader(str);
 
-	struct yastrhdr * tmp = realloc(hdr, sizeof(struct yastrhdr) + hdr->len + 1);
+	struct yastrhdr * tmp = YASL_REALLOC(hdr, sizeof(struct yastrhdr) + hdr->len + 1);
 	if (tmp) {
 		hdr = tmp;
 		hdr->free = 0;
@@ -0,0 +1,271 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yaslac.h"
+
+/* An Aho-Corasick automaton, compiled into a DFA so that scanning costs one
+ * table lookup per byte no matter how many patterns there are.
+ *
+ * Bytes that occur in no pattern all share class 0, the others get a class
+ * of their own, which keeps the rows of the transition table short. Each
+ * transition holds the row offset of the next state shifted left by one, with
+ * the low bit set if any pattern ends in that state. */
+struct yaslac {
+	uint8_t classes[256];
+	size_t classcount;
+	size_t * lens;               /* the length of each pattern */
+	uint32_t * delta;
+	uint32_t * dict;             /* the longest proper suffix state with matches */
+	uint32_t * outstart;         /* the patterns ending in state s are */
+	size_t * ids;                /* ids[outstart[s]] to ids[outstart[s + 1]] */
+};
+
+struct yaslacfirst {
+	size_t id;
+	size_t offset;
+};
+
+
+// Low-level helper functions //
+
+/* Report all patterns ending in the state with the encoded transition 's',
+ * right before byte 'end'. */
+static int
+yaslacreport(const struct yaslac * ac, uint32_t s, size_t end, yaslacmatchfn fn, void * ctx) {
+	uint32_t v = (uint32_t)((s >> 1) / ac->classcount);
+	int rv;
+
+	while (v) {
+		for (uint32_t k = ac->outstart[v]; k < ac->outstart[v + 1]; k++) {
+			size_t id = ac->ids[k];
+
+			rv = fn(id, end - ac->lens[id], ctx);
+			if (rv) { return rv; }
+		}
+		v = ac->dict[v];
+	}
+	return 0;
+}
+
+static int
+yaslacrun(const struct yaslac * ac, size_t * state, size_t base, const char * src, size_t len, yaslacmatchfn fn, void * ctx) {
+	const unsigned char * p = (const unsigned char *)src;
+	const uint8_t * classes = ac->classes;
+	const uint32_t * delta = ac->delta;
+	uint32_t s = (uint32_t)*state;
+	int rv = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		s = delta[(s >> 1) + classes[p[i]]];
+		if (s & 1) {
+			rv = yaslacreport(ac, s, base + i + 1, fn, ctx);
+			if (rv) { break; }
+		}
+	}
+	*state = s;
+	return rv;
+}
+
+static int
+yaslacfirst(size_t id, size_t offset, void * ctx) {
+	struct yaslacfirst * first = ctx;
+
+	first->id = id;
+	first->offset = offset;
+	return 1;
+}
+
+
+// Initialization //
+
+/* Compile the 'count' patterns into a matcher. Patterns are identified by
+ * their index in the array, and may contain any bytes. Returns NULL if any
+ * pattern is NULL or empty, if the automaton would be too large, or on out of
+ * memory. */
+struct yaslac *
+yaslacnew(const yastr * patterns, size_t count) {
+	if (!patterns || !count) { return NULL; }
+
+	struct yaslac * ac;
+	unsigned char used[256] = { 0 };
+	uint32_t * fail = NULL, * queue = NULL, * end = NULL;
+	size_t total = 1, states = 1, n, head = 0, tail = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!patterns[i] || !yasllen(patterns[i])) { return NULL; }
+		total += yasllen(patterns[i]);
+		for (size_t j = 0; j < yasllen(patterns[i]); j++) {
+			used[(unsigned char)patterns[i][j]] = 1;
+		}
+	}
+
+	ac = calloc(1, sizeof(*ac));
+	if (!ac) { return NULL; }
+	n = memchr(used, 0, sizeof(used)) ? 1 : 0;
+	for (size_t c = 0; c < 256; c++) {
+		if (used[c]) { ac->classes[c] = (uint8_t)n++; }
+	}
+	ac->classcount = n;
+	if (total > (UINT32_MAX >> 1) / n) { goto fail; }
+
+	ac->lens = malloc(count * sizeof(size_t));
+	ac->ids = malloc(count * sizeof(size_t));
+	ac->delta = calloc(total * n, sizeof(uint32_t));
+	ac->dict = calloc(total, sizeof(uint32_t));
+	ac->outstart = calloc(total + 1, sizeof(uint32_t));
+	fail = calloc(total, sizeof(uint32_t));
+	queue = malloc(total * sizeof(uint32_t));
+	end = malloc(count * sizeof(uint32_t));
+	if (!ac->lens || !ac->ids || !ac->delta || !ac->dict || !ac->outstart
+	    || !fail || !queue || !end) {
+		goto fail;
+	}
+
+	/* Build the trie, where 0 is both the root and a missing edge. */
+	for (size_t i = 0; i < count; i++) {
+		uint32_t s = 0;
+
+		ac->lens[i] = yasllen(patterns[i]);
+		for (size_t j = 0; j < ac->lens[i]; j++) {
+			uint32_t * e = &ac->delta[s * n + ac->classes[(unsigned char)patterns[i][j]]];
+
+			if (!*e) { *e = (uint32_t)states++; }
+			s = *e;
+		}
+		end[i] = s;
+		ac->outstart[s + 1]++;
+	}
+	for (size_t s = 1; s <= states; s++) {
+		ac->outstart[s] += ac->outstart[s - 1];
+	}
+	for (size_t i = 0; i < count; i++) {
+		ac->ids[ac->outstart[end[i]]++] = i;
+	}
+	for (size_t s = states; s > 0; s--) {
+		ac->outstart[s] = ac->outstart[s - 1];
+	}
+	ac->outstart[0] = 0;
+
+	/* Turn the trie into a DFA in breadth first order, so that the failure
+	 * state of every state, which is shallower, is complete already. */
+	for (size_t c = 0; c < n; c++) {
+		if (ac->delta[c]) { queue[tail++] = ac->delta[c]; }
+	}
+	while (head < tail) {
+		uint32_t u = queue[head++];
+
+		for (size_t c = 0; c < n; c++) {
+			uint32_t v = ac->delta[u * n + c];
+			uint32_t f = ac->delta[fail[u] * n + c];
+
+			if (!v) {
+				ac->delta[u * n + c] = f;
+				continue;
+			}
+			fail[v] = f;
+			ac->dict[v] = ac->outstart[f + 1] > ac->outstart[f] ? f : ac->dict[f];
+			queue[tail++] = v;
+		}
+	}
+	for (size_t k = 0; k < states * n; k++) {
+		uint32_t v = ac->delta[k];
+		uint32_t out = ac->outstart[v + 1] > ac->outstart[v] || ac->dict[v];
+
+		ac->delta[k] = (uint32_t)(v * n) << 1 | out;
+	}
+
+	free(fail);
+	free(queue);
+	free(end);
+	return ac;
+
+fail:
+	free(fail);
+	free(queue);
+	free(end);
+	yaslacfree(ac);
+	return NULL;
+}
+
+/* Initialize a stream for yaslacfeed(). */
+void
+yaslacstreaminit(struct yaslacstream * stream) {
+	if (!stream) { return; }
+
+	stream->state = 0;
+	stream->offset = 0;
+}
+
+
+// Querying //
+
+/* Return the offset of the match in 'src' that ends first, and store the id
+ * of its pattern in '*id' unless it is NULL. Of the matches ending at the
+ * same byte the longest is returned. Returns -1 if nothing matches. */
+ptrdiff_t
+yaslacfind(const struct yaslac * ac, const char * src, size_t len, size_t * id) {
+	if (!ac || !src) { return -1; }
+
+	struct yaslacfirst first;
+	size_t state = 0;
+
+	if (!yaslacrun(ac, &state, 0, src, len, yaslacfirst, &first)) { return -1; }
+	if (id) { *id = first.id; }
+	return (ptrdiff_t)first.offset;
+}
+
+/* Call 'fn' for every match in 'src', including overlapping ones, in the
+ * order of the bytes they end at, and from the longest to the shortest for
+ * matches ending at the same byte. Returns 0, or the first non-zero value
+ * returned by 'fn', or -1 if any argument is NULL. */
+int
+yaslacscan(const struct yaslac * ac, const char * src, size_t len, yaslacmatchfn fn, void * ctx) {
+	if (!ac || !src || !fn) { return -1; }
+
+	size_t state = 0;
+
+	return yaslacrun(ac, &state, 0, src, len, fn, ctx);
+}
+
+
+// Modification //
+
+/* Like yaslacscan(), but for text split into chunks, which are fed to the
+ * stream in order. Matches that span chunks are found, and their offsets are
+ * counted from the start of the stream. If 'fn' returns non-zero, the rest of
+ * the chunk is skipped. */
+int
+yaslacfeed(const struct yaslac * ac, struct yaslacstream * stream, const char * chunk, size_t len, yaslacmatchfn fn, void * ctx) {
+	if (!ac || !stream || !chunk || !fn) { return -1; }
+
+	size_t base = stream->offset;
+
+	stream->offset += len;
+	return yaslacrun(ac, &stream->state, base, chunk, len, fn, ctx);
+}
+
+
+// Freeing //
+
+/* Free a matcher. No operation is performed if 'ac' is NULL. */
+void
+yaslacfree(struct yaslac * ac) {
+	if (!ac) { return; }
+
+	free(ac->lens);
+	free(ac->ids);
+	free(ac->delta);
+	free(ac->dict);
+	free(ac->outstart);
+	free(ac);
+}
@@ -0,0 +1,223 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yaslbuf.h"
+
+#define YASLBUF_SPINS 64
+
+/* A slot of the ring, which holds segment number 'seq'. Segment 'n' covers
+ * the bytes of the stream from n * segsize on, and goes to slot n % count. */
+struct yaslbufseg {
+	yastr data;
+	uint64_t seq;                /* set by the consumer once it is free */
+	size_t committed;            /* the bytes written by the producers */
+	size_t end;                  /* the length of the segment, for the consumer */
+};
+
+/* The position of the next byte to reserve is alone on its cache line, since
+ * every producer updates it, and the rest is only written by the consumer.
+ * It is padded on both sides, as malloc() does not align to cache lines. */
+struct yaslbuf {
+	char before[64 - sizeof(uint64_t)];
+	uint64_t head;
+	char after[64 - sizeof(uint64_t)];
+	uint64_t tail;               /* the first segment not drained yet */
+	size_t segsize;
+	size_t count;
+	struct yaslbufseg segs[];
+};
+
+
+// Low-level helper functions //
+
+/* The slot of segment number 'n'. */
+static inline struct yaslbufseg *
+yaslbufslot(struct yaslbuf * buf, uint64_t n) {
+	return &buf->segs[n % buf->count];
+}
+
+/* Whether the consumer has seen all the bytes of segment 'seg' written. */
+static inline int
+yaslbufdone(const struct yaslbufseg * seg) {
+	return __atomic_load_n(&seg->committed, __ATOMIC_ACQUIRE) == seg->end;
+}
+
+/* Wait until the consumer has drained the segment that was in the slot
+ * 'seg' before segment 'n'. */
+static void
+yaslbufwait(const struct yaslbufseg * seg, uint64_t n) {
+	for (unsigned spins = 0; __atomic_load_n(&seg->seq, __ATOMIC_ACQUIRE) != n; spins++) {
+		if (spins >= YASLBUF_SPINS) { sched_yield(); }
+	}
+}
+
+
+// Initialization //
+
+/* Create an append buffer made of a ring of 'segments' yasl strings of
+ * 'segsize' bytes each, allocated up front. Any number of threads can append
+ * to it at once, and a single one drains it. Returns NULL on out of memory,
+ * or if either size is zero. */
+struct yaslbuf *
+yaslbufnew(size_t segsize, size_t segments) {
+	if (!segsize || !segments) { return NULL; }
+
+	struct yaslbuf * buf;
+
+	if (segments > (SIZE_MAX - sizeof(*buf)) / sizeof(struct yaslbufseg)) { return NULL; }
+	buf = calloc(1, sizeof(*buf) + segments * sizeof(struct yaslbufseg));
+	if (!buf) { return NULL; }
+
+	buf->segsize = segsize;
+	buf->count = segments;
+	for (size_t i = 0; i < segments; i++) {
+		/* The contents are zeroed, so that the pages are mapped. */
+		buf->segs[i].data = yaslnew(NULL, segsize);
+		if (!buf->segs[i].data) {
+			yaslbuffree(buf);
+			return NULL;
+		}
+		yaslclear(buf->segs[i].data);
+		buf->segs[i].seq = i;
+		buf->segs[i].end = segsize;
+	}
+	return buf;
+}
+
+
+// Querying //
+
+/* Fill 'iov' with up to 'max' segments of 'buf' that are completely written,
+ * oldest first, and return their number. They stay in the buffer until
+ * yaslbufrelease() is called. Only the consumer thread may call this. */
+size_t
+yaslbufpeek(struct yaslbuf * buf, struct iovec * iov, size_t max) {
+	if (!buf || !iov) { return 0; }
+
+	size_t i;
+
+	for (i = 0; i < max && i < buf->count; i++) {
+		struct yaslbufseg * seg = yaslbufslot(buf, buf->tail + i);
+
+		if (!yaslbufdone(seg)) { break; }
+		iov[i].iov_base = seg->data;
+		iov[i].iov_len = seg->end;
+	}
+	return i;
+}
+
+
+// Modification //
+
+/* Append 'len' bytes from 'src' to 'buf'. The space is reserved with a
+ * single atomic addition, so that appends from different threads never wait
+ * for each other, and the bytes of each append are contiguous in the stream.
+ * An append only waits if the ring is full, until the consumer drains the
+ * segments it needs. Returns 0 on success and -1 on invalid input. */
+int
+yaslbufappend(struct yaslbuf * buf, const void * src, size_t len) {
+	if (!buf || (!src && len)) { return -1; }
+
+	const char * from = src;
+	uint64_t pos = __atomic_fetch_add(&buf->head, len, __ATOMIC_RELAXED);
+
+	/* An append may span several segments, which are drained in order. */
+	while (len) {
+		uint64_t n = pos / buf->segsize;
+		size_t off = (size_t)(pos % buf->segsize);
+		size_t chunk = buf->segsize - off < len ? buf->segsize - off : len;
+		struct yaslbufseg * seg = yaslbufslot(buf, n);
+
+		yaslbufwait(seg, n);
+		memcpy(seg->data + off, from, chunk);
+		__atomic_fetch_add(&seg->committed, chunk, __ATOMIC_RELEASE);
+		from += chunk;
+		pos += chunk;
+		len -= chunk;
+	}
+	return 0;
+}
+
+/* End the segment that is being written early, so that it can be drained as
+ * soon as the appends in progress are done, and later appends go to the next
+ * one. Nothing is done if the ring is full. Only the consumer thread may call
+ * this. */
+void
+yaslbufflush(struct yaslbuf * buf) {
+	if (!buf) { return; }
+
+	uint64_t pos = __atomic_load_n(&buf->head, __ATOMIC_RELAXED), n;
+
+	do {
+		n = pos / buf->segsize;
+		if (!(pos % buf->segsize) || n - buf->tail >= buf->count) { return; }
+	} while (!__atomic_compare_exchange_n(&buf->head, &pos, (n + 1) * buf->segsize, 0,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	yaslbufslot(buf, n)->end = (size_t)(pos % buf->segsize);
+}
+
+/* Give the 'count' oldest segments returned by yaslbufpeek() back to the
+ * producers. Only the consumer thread may call this. */
+void
+yaslbufrelease(struct yaslbuf * buf, size_t count) {
+	if (!buf) { return; }
+
+	for (size_t i = 0; i < count; i++) {
+		struct yaslbufseg * seg = yaslbufslot(buf, buf->tail);
+
+		if (!yaslbufdone(seg)) { return; }
+		yaslclear(seg->data);
+		__atomic_store_n(&seg->committed, 0, __ATOMIC_RELAXED);
+		seg->end = buf->segsize;
+		__atomic_store_n(&seg->seq, buf->tail + buf->count, __ATOMIC_RELEASE);
+		buf->tail++;
+	}
+}
+
+/* Remove the oldest segment of 'buf' if it is completely written, and return
+ * it as a yasl string, which is replaced with a new one in the ring. Returns
+ * NULL if there is no such segment, or on out of memory. Only the consumer
+ * thread may call this. */
+yastr
+yaslbufpop(struct yaslbuf * buf) {
+	if (!buf) { return NULL; }
+
+	struct yaslbufseg * seg = yaslbufslot(buf, buf->tail);
+	yastr str = seg->data, fresh;
+
+	if (!yaslbufdone(seg)) { return NULL; }
+	fresh = yaslnew(NULL, buf->segsize);
+	if (!fresh) { return NULL; }
+
+	yaslclear(fresh);
+	yaslIncrLen(str, seg->end);
+	seg->data = fresh;
+	yaslbufrelease(buf, 1);
+	return str;
+}
+
+
+// Freeing //
+
+/* Free an append buffer and the segments it holds. No thread may be using
+ * it. No operation is performed if 'buf' is NULL. */
+void
+yaslbuffree(struct yaslbuf * buf) {
+	if (!buf) { return; }
+
+	for (size_t i = 0; i < buf->count; i++) {
+		yaslfree(buf->segs[i].data);
+	}
+	free(buf);
+}
@@ -0,0 +1,242 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "yaslcsv.h"
+
+struct yaslcsv {
+	char sep;
+	char quote;
+	int inquote;                 /* quote parity of the bytes in 'carry' */
+	yastr carry;                 /* the start of a row that spans chunks */
+	yastr scratch;               /* unescaped fields of the current row */
+	struct yaslcsvfield * fields;
+	size_t slots;
+};
+
+
+// Initialization //
+
+/* Create a streaming parser for rows of fields separated by 'sep', which may
+ * be quoted with 'quote' as described in RFC 4180. A 'quote' of '\0'
+ * disables quoting, which is useful for plain TSV. */
+struct yaslcsv *
+yaslcsvnew(char sep, char quote) {
+	struct yaslcsv * csv = calloc(1, sizeof(*csv));
+	if (!csv) { return NULL; }
+
+	csv->sep = sep;
+	csv->quote = quote;
+	csv->carry = yaslempty();
+	csv->scratch = yaslempty();
+	csv->slots = 16;
+	csv->fields = malloc(sizeof(*csv->fields) * csv->slots);
+	if (!csv->carry || !csv->scratch || !csv->fields) {
+		yaslcsvfree(csv);
+		return NULL;
+	}
+	return csv;
+}
+
+
+// Modification //
+
+/* Return the newline that ends the row starting at 'p', or NULL if the row
+ * does not end before 'end'. A newline ends the row unless it is inside
+ * quotes, which is tracked as the parity of the quotes seen so far in
+ * '*inquote'. Doubled quotes flip the parity twice, so they need no special
+ * handling here. */
+static const char *
+yaslcsvrowend(const char * p, const char * end, char quote, int * inquote) {
+#ifdef __SSE2__
+	const __m128i q = _mm_set1_epi8(quote), nl = _mm_set1_epi8('\n');
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const void *)p);
+		unsigned quotes = quote ? (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) : 0;
+		unsigned newlines = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl));
+
+		if (newlines) {
+			/* A prefix xor of the quote mask sets every bit that is
+			 * preceded by an odd number of quotes in this block. */
+			unsigned inside = quotes;
+			inside ^= inside << 1;
+			inside ^= inside << 2;
+			inside ^= inside << 4;
+			inside ^= inside << 8;
+			if (*inquote) { inside = ~inside; }
+			newlines &= ~inside & 0xFFFF;
+			if (newlines) {
+				*inquote = 0;
+				return p + __builtin_ctz(newlines);
+			}
+		}
+		*inquote ^= __builtin_popcount(quotes) & 1;
+		p += 16;
+	}
+#endif
+	for (; p < end; p++) {
+		if (*p == '\n' && !*inquote) { return p; }
+		if (quote && *p == quote) { *inquote = !*inquote; }
+	}
+	return NULL;
+}
+
+/* Split the complete row [p, end) into fields and pass them to 'fn'. Fields
+ * are sliced out of the row, except for quoted fields with doubled quotes,
+ * which are unescaped into the scratch buffer. */
+static int
+yaslcsvrow(struct yaslcsv * csv, const char * p, const char * end, yaslcsvrowfn fn, void * ctx) {
+	struct yaslcsvfield * f;
+	const char * q, * start;
+	size_t count = 0, off = 0;
+	int escaped;
+	yastr tmp;
+
+	if (end > p && end[-1] == '\r') { end--; }
+	if (p == end) { return 0; }
+	yaslclear(csv->scratch);
+
+	for (;;) {
+		if (count == csv->slots) {
+			f = realloc(csv->fields, sizeof(*f) * csv->slots * 2);
+			if (!f) { return -1; }
+			csv->fields = f;
+			csv->slots *= 2;
+		}
+		f = &csv->fields[count++];
+
+		if (!csv->quote || p == end || *p != csv->quote) {
+			q = memchr(p, csv->sep, (size_t)(end - p));
+			f->data = p;
+			f->len = (size_t)((q ? q : end) - p);
+			/* Quotes are only allowed around a whole field. */
+			if (csv->quote && memchr(p, csv->quote, f->len)) { return -1; }
+			if (!q) { break; }
+			p = q + 1;
+			continue;
+		}
+
+		start = ++p;
+		escaped = 0;
+		while ((q = memchr(p, csv->quote, (size_t)(end - p))) &&
+		       q + 1 < end && q[1] == csv->quote) {
+			escaped = 1;
+			p = q + 2;
+		}
+		if (!q) { return -1; }
+		if (escaped) {
+			/* Unescaped fields are marked with a NULL data pointer, and
+			 * pointed into the scratch buffer once it stops growing. */
+			f->data = NULL;
+			off = yasllen(csv->scratch);
+			for (p = start; (start = memchr(p, csv->quote, (size_t)(q - p))); p = start + 2) {
+				tmp = yaslcatlen(csv->scratch, p, (size_t)(start - p) + 1);
+				if (!tmp) { return -1; }
+				csv->scratch = tmp;
+			}
+			tmp = yaslcatlen(csv->scratch, p, (size_t)(q - p));
+			if (!tmp) { return -1; }
+			csv->scratch = tmp;
+			f->len = yasllen(csv->scratch) - off;
+		} else {
+			f->data = start;
+			f->len = (size_t)(q - start);
+		}
+		p = q + 1;
+		if (p == end) { break; }
+		if (*p != csv->sep) { return -1; }
+		p++;
+	}
+
+	off = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (!csv->fields[i].data) {
+			csv->fields[i].data = csv->scratch + off;
+			off += csv->fields[i].len;
+		}
+	}
+	return fn(csv->fields, count, ctx);
+}
+
+/* Parse the next 'len' bytes of input, calling 'fn' for every row that is
+ * completed by them. A row that is not complete at the end of the chunk is
+ * kept until more input arrives. Returns 0 on success, -1 on malformed input
+ * or out of memory, or the non-zero value returned by 'fn'. */
+int
+yaslcsvfeed(struct yaslcsv * csv, const char * chunk, size_t len, yaslcsvrowfn fn, void * ctx) {
+	if (!csv || !chunk || !fn) { return -1; }
+
+	const char * p = chunk, * end = chunk + len, * nl;
+	yastr tmp;
+	int ret;
+
+	if (yasllen(csv->carry)) {
+		nl = yaslcsvrowend(p, end, csv->quote, &csv->inquote);
+		tmp = yaslcatlen(csv->carry, p, (size_t)((nl ? nl : end) - p));
+		if (!tmp) { return -1; }
+		csv->carry = tmp;
+		if (!nl) { return 0; }
+
+		ret = yaslcsvrow(csv, csv->carry, csv->carry + yasllen(csv->carry), fn, ctx);
+		yaslclear(csv->carry);
+		if (ret) { return ret; }
+		p = nl + 1;
+	}
+
+	while ((nl = yaslcsvrowend(p, end, csv->quote, &csv->inquote))) {
+		ret = yaslcsvrow(csv, p, nl, fn, ctx);
+		if (ret) { return ret; }
+		p = nl + 1;
+	}
+
+	if (p < end) {
+		tmp = yaslcatlen(csv->carry, p, (size_t)(end - p));
+		if (!tmp) { return -1; }
+		csv->carry = tmp;
+	}
+	return 0;
+}
+
+/* Signal the end of the input, calling 'fn' for the last row if it was not
+ * terminated by a newline. Returns -1 if the input ended inside quotes. */
+int
+yaslcsvfinish(struct yaslcsv * csv, yaslcsvrowfn fn, void * ctx) {
+	if (!csv || !fn) { return -1; }
+
+	int ret = 0;
+
+	if (csv->inquote) {
+		ret = -1;
+	} else if (yasllen(csv->carry)) {
+		ret = yaslcsvrow(csv, csv->carry, csv->carry + yasllen(csv->carry), fn, ctx);
+	}
+	yaslclear(csv->carry);
+	csv->inquote = 0;
+	return ret;
+}
+
+
+// Freeing //
+
+/* Free a parser created with yaslcsvnew(). */
+void
+yaslcsvfree(struct yaslcsv * csv) {
+	if (!csv) { return; }
+
+	yaslfree(csv->carry);
+	yaslfree(csv->scratch);
+	free(csv->fields);
+	free(csv);
+}
@@ -0,0 +1,219 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yasldist.h"
+
+/* A pattern prepared for bit-parallel edit distance. Row i of the matrix of
+ * distances is bit i % 64 of word i / 64 of each column. */
+struct yasldist {
+	size_t len;
+	size_t words;
+	uint64_t * pv;               /* the vertical deltas of +1 and -1 of */
+	uint64_t * mv;               /* the current column, for long patterns */
+	uint64_t peq[];              /* the rows matching each byte, [256][words] */
+};
+
+
+// Low-level helper functions //
+
+/* The bit of row 's' in 'x', as 0 or 1. */
+static inline size_t
+yasldistbit(uint64_t x, size_t s) {
+	return (size_t)(x >> (s & 63)) & 1;
+}
+
+/* The edit distance between a pattern of 1 to 64 bytes, with the rows where
+ * each byte appears in 'peq', and 'str', or -1 if it is more than 'max'.
+ *
+ * This is the algorithm of Myers, as adapted to edit distance by Hyyrö: each
+ * column of the matrix of distances is kept as two bit vectors of its
+ * vertical deltas of +1 and -1, and the next column is derived from them
+ * with a dozen word operations. The distances along a diagonal never
+ * decrease, so the distance on the diagonal that ends at the last cell is
+ * tracked as well, which gives up as soon as it is more than 'max'. */
+static ptrdiff_t
+yasldist64(const uint64_t * peq, size_t m, const char * str, size_t n, size_t max) {
+	uint64_t pv = ~UINT64_C(0), mv = 0, bit = 1;
+	size_t diag = m > n ? m - n : n - m;
+
+	if (diag > max) { return -1; }
+	/* The diagonal starts at row m - n of the first column if n < m. */
+	if (n && m > n) { bit <<= m - n; }
+	for (size_t j = 0; j < n; j++) {
+		uint64_t eq = peq[(unsigned char)str[j]];
+		uint64_t xv = eq | mv;
+		uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+		uint64_t ph = (mv | ~(xh | pv)) << 1 | 1;
+		uint64_t mh = (pv & xh) << 1;
+
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+		if (j + m < n) { continue; }
+
+		/* The diagonal is at row j + m - n of this column. */
+		diag += !!(ph & bit) + !!(pv & bit);
+		diag -= !!(mh & bit) + !!(mv & bit);
+		if (diag > max) { return -1; }
+		bit <<= 1;
+	}
+	return (ptrdiff_t)diag;
+}
+
+/* Like yasldist64(), for a pattern of any length, split into blocks of 64
+ * rows that pass their horizontal deltas down to the next one. */
+static ptrdiff_t
+yasldistlong(struct yasldist * dist, const char * str, size_t n, size_t max) {
+	size_t m = dist->len, words = dist->words;
+	size_t diag = m > n ? m - n : n - m;
+
+	if (diag > max) { return -1; }
+	for (size_t b = 0; b < words; b++) {
+		dist->pv[b] = ~UINT64_C(0);
+		dist->mv[b] = 0;
+	}
+	for (size_t j = 0; j < n; j++) {
+		const uint64_t * peq = dist->peq + (unsigned char)str[j] * words;
+		size_t s = j + m - n, sb = j + m >= n ? s / 64 : words;
+		uint64_t hinp = 1, hinm = 0;
+
+		for (size_t b = 0; b < words; b++) {
+			uint64_t pv = dist->pv[b], mv = dist->mv[b];
+			uint64_t eq = peq[b] | hinm, xv = peq[b] | mv;
+			uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+			uint64_t ph = mv | ~(xh | pv);
+			uint64_t mh = pv & xh;
+			uint64_t houtp = ph >> 63, houtm = mh >> 63;
+
+			ph = (ph << 1) | hinp;
+			mh = (mh << 1) | hinm;
+			pv = mh | ~(xv | ph);
+			mv = ph & xv;
+			dist->pv[b] = pv;
+			dist->mv[b] = mv;
+			if (b == sb) {
+				diag += yasldistbit(ph, s) + yasldistbit(pv, s);
+				diag -= yasldistbit(mh, s) + yasldistbit(mv, s);
+			}
+			hinp = houtp;
+			hinm = houtm;
+		}
+		if (diag > max) { return -1; }
+	}
+	return (ptrdiff_t)diag;
+}
+
+
+// Initialization //
+
+/* Prepare 'pattern' of length 'len' to compute its edit distance to many
+ * strings with yasldistmatch() or yasldistfilter(). */
+struct yasldist *
+yasldistnew(const char * pattern, size_t len) {
+	if (!pattern && len) { return NULL; }
+
+	size_t words = len ? (len + 63) / 64 : 1;
+	struct yasldist * dist;
+
+	if (words > (SIZE_MAX - sizeof(*dist)) / sizeof(uint64_t) / 258) { return NULL; }
+	dist = malloc(sizeof(*dist) + 258 * words * sizeof(uint64_t));
+	if (!dist) { return NULL; }
+
+	dist->len = len;
+	dist->words = words;
+	dist->pv = dist->peq + 256 * words;
+	dist->mv = dist->pv + words;
+	memset(dist->peq, 0, 256 * words * sizeof(uint64_t));
+	for (size_t i = 0; i < len; i++) {
+		dist->peq[(unsigned char)pattern[i] * words + i / 64] |= UINT64_C(1) << (i % 64);
+	}
+	return dist;
+}
+
+
+// Querying //
+
+/* Return the edit distance between 'a' of length 'alen' and 'b' of length
+ * 'blen', the smallest number of bytes to insert, delete or replace to turn
+ * one into the other, or -1 if it is more than 'max'. Pass SIZE_MAX as 'max'
+ * for no limit. Strings of up to 64 bytes need no memory, and -1 is also
+ * returned if there is none for longer ones. */
+ptrdiff_t
+yasldistance(const char * a, size_t alen, const char * b, size_t blen, size_t max) {
+	if ((!a && alen) || (!b && blen)) { return -1; }
+
+	if (alen > blen) {
+		const char * t = a;
+		size_t tlen = alen;
+
+		a = b;
+		alen = blen;
+		b = t;
+		blen = tlen;
+	}
+	if (!alen) { return blen <= max ? (ptrdiff_t)blen : -1; }
+
+	if (alen <= 64) {
+		uint64_t peq[256];
+
+		/* Only the rows of the bytes of either string are ever read. */
+		for (size_t j = 0; j < blen; j++) { peq[(unsigned char)b[j]] = 0; }
+		for (size_t i = 0; i < alen; i++) { peq[(unsigned char)a[i]] = 0; }
+		for (size_t i = 0; i < alen; i++) { peq[(unsigned char)a[i]] |= UINT64_C(1) << i; }
+		return yasldist64(peq, alen, b, blen, max);
+	}
+
+	struct yasldist * dist = yasldistnew(a, alen);
+	ptrdiff_t d = yasldistmatch(dist, b, blen, max);
+
+	yasldistfree(dist);
+	return d;
+}
+
+/* Return the edit distance between the pattern of 'dist' and 'str' of length
+ * 'len', or -1 if it is more than 'max'. Strings whose length differs from
+ * the one of the pattern by more than 'max' are rejected right away, and
+ * others as soon as their distance is known to be more than 'max'. */
+ptrdiff_t
+yasldistmatch(struct yasldist * dist, const char * str, size_t len, size_t max) {
+	if (!dist || (!str && len)) { return -1; }
+
+	if (!dist->len) { return len <= max ? (ptrdiff_t)len : -1; }
+	if (dist->words == 1) { return yasldist64(dist->peq, dist->len, str, len, max); }
+	return yasldistlong(dist, str, len, max);
+}
+
+/* Compute the edit distance between the pattern of 'dist' and each of the
+ * 'count' yasl strings of 'strs', storing them in 'distances', or -1 for the
+ * ones that are more than 'max'. Returns the number of strings within 'max'
+ * of the pattern. */
+size_t
+yasldistfilter(struct yasldist * dist, const yastr * strs, size_t count, size_t max, ptrdiff_t * distances) {
+	if (!dist || !strs || !distances) { return 0; }
+
+	size_t found = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		distances[i] = yasldistmatch(dist, strs[i], yasllen(strs[i]), max);
+		found += distances[i] >= 0;
+	}
+	return found;
+}
+
+
+// Freeing //
+
+/* Free a prepared pattern. No operation is performed if 'dist' is NULL. */
+void
+yasldistfree(struct yasldist * dist) {
+	free(dist);
+}
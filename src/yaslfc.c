@@ -0,0 +1,361 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yaslfc.h"
+
+#define YASLFC_INTERVAL 16           /* keys per block, by default */
+
+/* A sorted array of keys, front-coded in blocks of 'interval' keys. Each key
+ * is stored as the length of the prefix it shares with the key before it and
+ * the length of the rest, as varints, followed by the rest. The first key of
+ * each block, its restart key, shares nothing and is stored whole, so that
+ * blocks can be searched and decoded on their own. */
+struct yaslfc {
+	size_t count;
+	size_t interval;
+	size_t blocks;
+	size_t size;
+	unsigned char * data;
+	size_t restarts[];           /* the offset of each block in 'data' */
+};
+
+
+// Low-level helper functions //
+
+static size_t
+yaslfcvarintlen(size_t v) {
+	size_t n = 1;
+
+	while (v >= 0x80) {
+		v >>= 7;
+		n++;
+	}
+	return n;
+}
+
+static unsigned char *
+yaslfcputvarint(unsigned char * p, size_t v) {
+	while (v >= 0x80) {
+		*p++ = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+/* Read a varint written by yaslfcputvarint(), and return the byte after it. */
+static const unsigned char *
+yaslfcgetvarint(const unsigned char * p, size_t * v) {
+	unsigned shift = 0;
+
+	*v = 0;
+	while (*p & 0x80) {
+		*v |= (size_t)(*p++ & 0x7f) << shift;
+		shift += 7;
+	}
+	*v |= (size_t)*p++ << shift;
+	return p;
+}
+
+/* Read the shared length and the length of the rest of the key at 'p', and
+ * return the start of the rest. */
+static const unsigned char *
+yaslfcentry(const unsigned char * p, size_t * shared, size_t * len) {
+	return yaslfcgetvarint(yaslfcgetvarint(p, shared), len);
+}
+
+/* The length of the common prefix of 'a' and 'b'. */
+static size_t
+yaslfcprefix(const yastr a, const yastr b) {
+	size_t n = yasllen(a) < yasllen(b) ? yasllen(a) : yasllen(b), i = 0;
+
+	while (i < n && a[i] == b[i]) { i++; }
+	return i;
+}
+
+/* Compare 'a' of length 'alen' with 'b' of length 'blen' like yaslcmp(). */
+static int
+yaslfccmp(const void * a, size_t alen, const void * b, size_t blen) {
+	int cmp = memcmp(a, b, alen < blen ? alen : blen);
+
+	return cmp ? cmp : (alen > blen) - (alen < blen);
+}
+
+/* Truncate 'str' to 'len' bytes. Nothing is written if it is that long
+ * already, so that it may still be static. */
+static void
+yaslfctrunc(yastr str, size_t len) {
+	if (yasllen(str) == len) { return; }
+	if (len) {
+		yaslrange(str, 0, (ptrdiff_t)len - 1);
+	} else {
+		yaslclear(str);
+	}
+}
+
+/* Return the index of the first key of 'fc' that is not smaller than 'key'
+ * of length 'len', or the number of keys if there is none, and store in
+ * '*found' whether it is equal to 'key'.
+ *
+ * The last block whose restart key is smaller than 'key' is found with a
+ * binary search, and its keys are then compared without decoding them: while
+ * they are smaller than 'key', a key that shares more with the one before it
+ * than the one before it shares with 'key' is smaller too, and one that
+ * shares less is larger, so only the rest of the keys that share exactly as
+ * much is compared. */
+static size_t
+yaslfcsearch(const struct yaslfc * fc, const char * key, size_t len, int * found) {
+	const unsigned char * p, * rest;
+	size_t lo = 0, hi = fc->blocks, i, end, shared, n, match = 0;
+	int cmp = -1;
+
+	*found = 0;
+	if (!fc->count) { return 0; }
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		rest = yaslfcentry(fc->data + fc->restarts[mid], &shared, &n);
+		if (yaslfccmp(rest, n, key, len) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo) { lo--; }
+
+	p = fc->data + fc->restarts[lo];
+	i = lo * fc->interval;
+	end = fc->count - i < fc->interval ? fc->count : i + fc->interval;
+	for (; i < end; i++) {
+		size_t j = 0;
+
+		rest = yaslfcentry(p, &shared, &n);
+		p = rest + n;
+		if (shared < match) { return i; }
+		if (shared > match) { continue; }
+
+		while (j < n && match < len && rest[j] == (unsigned char)key[match]) {
+			j++;
+			match++;
+		}
+		if (j < n && match < len) {
+			cmp = rest[j] < (unsigned char)key[match] ? -1 : 1;
+		} else {
+			cmp = (j < n) - (match < len);
+		}
+		if (cmp >= 0) {
+			*found = !cmp;
+			return i;
+		}
+	}
+	/* The next key is the restart key of the next block, which is not
+	 * smaller than 'key'. */
+	if (i < fc->count) {
+		rest = yaslfcentry(fc->data + fc->restarts[lo + 1], &shared, &n);
+		*found = !yaslfccmp(rest, n, key, len);
+	}
+	return i;
+}
+
+/* Decode the next key of the iterator into 'it->key'. Returns 0, or -1 on
+ * out of memory. */
+static int
+yaslfcstep(struct yaslfciter * it) {
+	const unsigned char * rest;
+	size_t shared, n;
+	yastr key;
+
+	if (!(it->next % it->fc->interval)) { it->pos = it->fc->restarts[it->next / it->fc->interval]; }
+	rest = yaslfcentry(it->fc->data + it->pos, &shared, &n);
+	yaslfctrunc(it->key, shared);
+	key = yaslcatlen(it->key, rest, n);
+	if (!key) { return -1; }
+
+	it->key = key;
+	it->pos = (size_t)(rest + n - it->fc->data);
+	it->index = it->next++;
+	return 0;
+}
+
+
+// Initialization //
+
+/* Create a front-coded array of the 'count' yasl strings of 'strs', which
+ * must be sorted like yaslsort() does, with a restart key every 'interval'
+ * keys, or 16 if it is 0. Longer blocks take less memory but are slower to
+ * search. Returns NULL on out of memory, or if the strings are not sorted. */
+struct yaslfc *
+yaslfcnew(const yastr * strs, size_t count, size_t interval) {
+	if (!strs && count) { return NULL; }
+
+	size_t blocks, size = 0;
+	struct yaslfc * fc;
+	unsigned char * p;
+
+	if (!interval) { interval = YASLFC_INTERVAL; }
+	blocks = count / interval + !!(count % interval);
+	for (size_t i = 0; i < count; i++) {
+		size_t shared = 0, n;
+
+		if (!strs[i]) { return NULL; }
+		if (i && yaslcmp(strs[i - 1], strs[i]) > 0) { return NULL; }
+		if (i % interval) { shared = yaslfcprefix(strs[i - 1], strs[i]); }
+		n = yasllen(strs[i]) - shared;
+		size += yaslfcvarintlen(shared) + yaslfcvarintlen(n) + n;
+	}
+
+	if (blocks > (SIZE_MAX - sizeof(*fc)) / sizeof(size_t)) { return NULL; }
+	fc = malloc(sizeof(*fc) + blocks * sizeof(size_t));
+	if (!fc) { return NULL; }
+
+	fc->data = malloc(size ? size : 1);
+	if (!fc->data) {
+		free(fc);
+		return NULL;
+	}
+	fc->count = count;
+	fc->interval = interval;
+	fc->blocks = blocks;
+	fc->size = size;
+	p = fc->data;
+	for (size_t i = 0; i < count; i++) {
+		size_t shared = 0;
+
+		if (i % interval) {
+			shared = yaslfcprefix(strs[i - 1], strs[i]);
+		} else {
+			fc->restarts[i / interval] = (size_t)(p - fc->data);
+		}
+		p = yaslfcputvarint(p, shared);
+		p = yaslfcputvarint(p, yasllen(strs[i]) - shared);
+		memcpy(p, strs[i] + shared, yasllen(strs[i]) - shared);
+		p += yasllen(strs[i]) - shared;
+	}
+	return fc;
+}
+
+/* Initialize an iterator over the keys of 'fc', positioned before the first
+ * one, which is freed with yaslfciterfree(). */
+void
+yaslfciterinit(struct yaslfciter * it, const struct yaslfc * fc) {
+	if (!it) { return; }
+
+	it->key = NULL;
+	it->index = 0;
+	it->fc = fc;
+	it->next = 0;
+	it->pos = 0;
+}
+
+
+// Querying //
+
+/* Return the number of keys in the array. */
+size_t
+yaslfccount(const struct yaslfc * fc) {
+	return fc ? fc->count : 0;
+}
+
+/* Return the number of bytes of memory used by the array. */
+size_t
+yaslfcsize(const struct yaslfc * fc) {
+	return fc ? sizeof(*fc) + fc->blocks * sizeof(size_t) + fc->size : 0;
+}
+
+/* Return the index of the key 'key' of length 'len', or -1 if it is not in
+ * the array. */
+ptrdiff_t
+yaslfcfind(const struct yaslfc * fc, const char * key, size_t len) {
+	if (!fc || (!key && len)) { return -1; }
+
+	int found;
+	size_t i = yaslfcsearch(fc, key, len, &found);
+
+	return found ? (ptrdiff_t)i : -1;
+}
+
+/* Position the iterator before the first key that is not smaller than 'key'
+ * of length 'len'. The keys of its block before it are decoded on the way.
+ * Returns 0, or -1 on out of memory. */
+int
+yaslfcseek(struct yaslfciter * it, const char * key, size_t len) {
+	if (!it || !it->fc || (!key && len)) { return -1; }
+
+	int found;
+	size_t i = yaslfcsearch(it->fc, key, len, &found);
+
+	if (!it->key && !(it->key = yaslempty())) { return -1; }
+	it->next = i - i % it->fc->interval;
+	while (it->next < i) {
+		if (yaslfcstep(it)) { return -1; }
+	}
+	return 0;
+}
+
+/* Move the iterator to the next key, and decode it into 'it->key', reusing
+ * its memory, and its index into 'it->index'. Returns 0, or -1 once all keys
+ * have been visited or on out of memory. */
+int
+yaslfcnext(struct yaslfciter * it) {
+	if (!it || !it->fc || it->next >= it->fc->count) { return -1; }
+
+	if (!it->key && !(it->key = yaslempty())) { return -1; }
+	return yaslfcstep(it);
+}
+
+
+// Concatenation //
+
+/* Append the key at 'index' of 'fc' to 'dest', decoding the keys of its
+ * block before it on the way. Returns NULL if 'index' is out of range, or on
+ * out of memory. */
+yastr
+yaslcatfc(yastr dest, const struct yaslfc * fc, size_t index) {
+	if (!dest || !fc || index >= fc->count) { return NULL; }
+
+	const unsigned char * p = fc->data + fc->restarts[index / fc->interval];
+	size_t start = yasllen(dest);
+
+	for (size_t i = index - index % fc->interval; i <= index; i++) {
+		const unsigned char * rest;
+		size_t shared, n;
+
+		rest = yaslfcentry(p, &shared, &n);
+		yaslfctrunc(dest, start + shared);
+		dest = yaslcatlen(dest, rest, n);
+		if (!dest) { return NULL; }
+		p = rest + n;
+	}
+	return dest;
+}
+
+
+// Freeing //
+
+/* Free a front-coded array. No operation is performed if 'fc' is NULL. */
+void
+yaslfcfree(struct yaslfc * fc) {
+	if (!fc) { return; }
+
+	free(fc->data);
+	free(fc);
+}
+
+/* Free the key of an iterator. */
+void
+yaslfciterfree(struct yaslfciter * it) {
+	if (!it) { return; }
+
+	yaslfree(it->key);
+	it->key = NULL;
+}
@@ -0,0 +1,246 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yaslglob.h"
+
+/* A compiled pattern. Every atom matches a single byte out of a set, so the
+ * stars split the pattern into segments of fixed length. The first segment is
+ * anchored at the start of the string and the last at the end, and in between
+ * each segment matches at its leftmost position after the previous one, which
+ * never needs to backtrack. */
+struct yaslglob {
+	size_t atomcount;            /* the length of a match without stars */
+	size_t segcount;             /* the number of stars plus one */
+	size_t * segs;               /* segment i is atoms segs[i] to segs[i + 1] */
+	unsigned char * literal;     /* per segment, whether 'bytes' matches it */
+	unsigned char * bytes;       /* per atom, the byte of a literal */
+	uint8_t (* sets)[32];        /* per atom, the bitmap of matching bytes */
+};
+
+
+// Low-level helper functions //
+
+static inline int
+yaslglobin(const uint8_t * set, unsigned char c) {
+	return (set[c >> 3] >> (c & 7)) & 1;
+}
+
+static inline void
+yaslglobadd(uint8_t * set, unsigned char c) {
+	set[c >> 3] |= (uint8_t)(1 << (c & 7));
+}
+
+/* Add the other case of every ASCII letter in 'set'. */
+static void
+yaslglobfold(uint8_t * set) {
+	for (unsigned char c = 'a'; c <= 'z'; c++) {
+		if (yaslglobin(set, c) || yaslglobin(set, (unsigned char)(c - 'a' + 'A'))) {
+			yaslglobadd(set, c);
+			yaslglobadd(set, (unsigned char)(c - 'a' + 'A'));
+		}
+	}
+}
+
+/* Parse the bracket expression after the '[' at 'p' into 'set', and return
+ * the end of it, or NULL if it is not terminated. A leading '^' or '!' negates
+ * it, a ']' right after them or the '[' is a literal, and a backslash escapes
+ * the next byte. */
+static const char *
+yaslglobclass(const char * p, const char * end, uint8_t * set, int nocase) {
+	int negate = 0, first = 1;
+
+	if (p < end && (*p == '^' || *p == '!')) {
+		negate = 1;
+		p++;
+	}
+	for (;;) {
+		unsigned lo, hi;
+
+		if (p == end) { return NULL; }
+		lo = (unsigned char)*p++;
+		if (lo == ']' && !first) { break; }
+		first = 0;
+		if (lo == '\\') {
+			if (p == end) { return NULL; }
+			lo = (unsigned char)*p++;
+		}
+		hi = lo;
+		if (end - p >= 2 && p[0] == '-' && p[1] != ']') {
+			p++;
+			hi = (unsigned char)*p++;
+			if (hi == '\\') {
+				if (p == end) { return NULL; }
+				hi = (unsigned char)*p++;
+			}
+			if (hi < lo) {
+				unsigned t = lo;
+				lo = hi;
+				hi = t;
+			}
+		}
+		for (unsigned c = lo; c <= hi; c++) {
+			yaslglobadd(set, (unsigned char)c);
+		}
+	}
+	if (nocase) { yaslglobfold(set); }
+	if (negate) {
+		for (size_t i = 0; i < 32; i++) { set[i] = (uint8_t)~set[i]; }
+	}
+	return p;
+}
+
+/* Whether segment 'i' matches at 's', which has room for it. */
+static inline int
+yaslglobseg(const struct yaslglob * glob, size_t i, const unsigned char * s) {
+	size_t start = glob->segs[i], n = glob->segs[i + 1] - start;
+
+	if (glob->literal[i]) { return !memcmp(glob->bytes + start, s, n); }
+	for (size_t k = 0; k < n; k++) {
+		if (!yaslglobin(glob->sets[start + k], s[k])) { return 0; }
+	}
+	return 1;
+}
+
+
+// Initialization //
+
+/* Compile the glob pattern 'pattern' of length 'len'. A '*' matches any
+ * number of bytes, a '?' any single byte, and '[...]' any byte of a set with
+ * ranges like 'a-z', negated with a leading '^' or '!'. A backslash escapes
+ * the next byte. With the YASLGLOB_NOCASE flag ASCII letters match regardless
+ * of case. Returns NULL if a bracket expression is not terminated, if the
+ * pattern ends in a backslash, or on out of memory. */
+struct yaslglob *
+yaslglobnew(const char * pattern, size_t len, int flags) {
+	if (!pattern) { return NULL; }
+
+	struct yaslglob * glob = calloc(1, sizeof(*glob));
+	const char * p = pattern, * end = pattern + len;
+	int nocase = flags & YASLGLOB_NOCASE;
+	size_t n = 0;
+
+	if (!glob) { return NULL; }
+	glob->segs = malloc((len + 2) * sizeof(size_t));
+	glob->literal = malloc(len + 1);
+	glob->bytes = malloc(len + 1);
+	glob->sets = calloc(len + 1, sizeof(*glob->sets));
+	if (!glob->segs || !glob->literal || !glob->bytes || !glob->sets) {
+		goto fail;
+	}
+
+	glob->segs[0] = 0;
+	glob->literal[0] = 1;
+	glob->segcount = 1;
+	while (p < end) {
+		uint8_t * set = glob->sets[n];
+		unsigned char c = (unsigned char)*p++;
+
+		if (c == '*') {
+			while (p < end && *p == '*') { p++; }
+			glob->segs[glob->segcount] = n;
+			glob->literal[glob->segcount++] = 1;
+			continue;
+		}
+		if (c == '?' || c == '[') {
+			if (c == '?') {
+				memset(set, 0xff, sizeof(*glob->sets));
+			} else if (!(p = yaslglobclass(p, end, set, nocase))) {
+				goto fail;
+			}
+			glob->literal[glob->segcount - 1] = 0;
+			n++;
+			continue;
+		}
+		if (c == '\\') {
+			if (p == end) { goto fail; }
+			c = (unsigned char)*p++;
+		}
+		glob->bytes[n] = c;
+		yaslglobadd(set, c);
+		if (nocase && ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')) {
+			yaslglobfold(set);
+			glob->literal[glob->segcount - 1] = 0;
+		}
+		n++;
+	}
+	glob->segs[glob->segcount] = n;
+	glob->atomcount = n;
+	return glob;
+
+fail:
+	yaslglobfree(glob);
+	return NULL;
+}
+
+
+// Querying //
+
+/* Return 1 if the whole string 'str' of length 'len' matches the pattern, or
+ * 0 otherwise. The segments before the first and after the last star are
+ * checked first, so most mismatches are rejected after a few bytes. */
+int
+yaslglobmatchlen(const struct yaslglob * glob, const char * str, size_t len) {
+	if (!glob || !str) { return 0; }
+
+	const unsigned char * s = (const unsigned char *)str;
+	size_t last = glob->segcount - 1, pos, end;
+
+	if (len < glob->atomcount) { return 0; }
+	if (!last) { return len == glob->atomcount && yaslglobseg(glob, 0, s); }
+	pos = glob->segs[1];
+	end = len - (glob->segs[last + 1] - glob->segs[last]);
+	if (!yaslglobseg(glob, 0, s) || !yaslglobseg(glob, last, s + end)) {
+		return 0;
+	}
+	for (size_t i = 1; i < last; i++) {
+		size_t n = glob->segs[i + 1] - glob->segs[i];
+
+		for (;;) {
+			if (end - pos < n) { return 0; }
+			if (glob->literal[i]) {
+				const unsigned char * hit = memchr(s + pos,
+				    glob->bytes[glob->segs[i]], end - pos - n + 1);
+
+				if (!hit) { return 0; }
+				pos = (size_t)(hit - s);
+			}
+			if (yaslglobseg(glob, i, s + pos)) { break; }
+			pos++;
+		}
+		pos += n;
+	}
+	return 1;
+}
+
+/* Like yaslglobmatchlen(), for a yasl string. */
+int
+yaslglobmatch(const struct yaslglob * glob, const yastr str) {
+	if (!str) { return 0; }
+
+	return yaslglobmatchlen(glob, str, yasllen(str));
+}
+
+
+// Freeing //
+
+/* Free a compiled pattern. No operation is performed if 'glob' is NULL. */
+void
+yaslglobfree(struct yaslglob * glob) {
+	if (!glob) { return; }
+
+	free(glob->segs);
+	free(glob->literal);
+	free(glob->bytes);
+	free(glob->sets);
+	free(glob);
+}
@@ -0,0 +1,541 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yasllz.h"
+
+/* The compressed format is a sequence of LZ4 style sequences: a token byte
+ * holding the number of literals in the high nibble and the match length
+ * minus YASLLZ_MINMATCH in the low nibble, where 15 means that more bytes
+ * follow, each adding up to 255, then the literals, and then the offset of the
+ * match as two little-endian bytes. The last sequence has only literals. */
+#define YASLLZ_MINMATCH 4
+#define YASLLZ_MAXOFFSET 65535
+#define YASLLZ_HASHBITS 12
+
+/* Streams are cut into blocks of at most this size, and keep this much of the
+ * preceding data around for matches that reach back into earlier blocks. */
+#define YASLLZ_BLOCK (256 * 1024)
+#define YASLLZ_WINDOW 65536
+
+/* The worst case size of a compressed block, which is all literals. */
+#define YASLLZ_BOUND(len) ((len) + (len) / 255 + 16)
+
+/* The maximum length of a varint header. */
+#define YASLLZ_VARINT 10
+
+struct yasllz {
+	size_t table[1 << YASLLZ_HASHBITS];  /* stream positions, by hash */
+	yastr window;                /* the most recent input or output */
+	size_t winpos;               /* stream position of the window start */
+	yastr pending;               /* a block that spans input chunks */
+	int state;                   /* 0 running, 1 ended, -1 failed */
+};
+
+
+// Low-level helper functions //
+
+static inline uint32_t
+yasllzread32(const unsigned char * p) {
+	uint32_t v;
+
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static inline size_t
+yasllzhash(uint32_t v, unsigned bits) {
+	return (size_t)((v * 2654435761U) >> (32 - bits));
+}
+
+/* Return how many bytes at 'a' match those at the earlier position 'b',
+ * without reading past 'end'. */
+static size_t
+yasllzcommon(const unsigned char * a, const unsigned char * b, const unsigned char * end) {
+	const unsigned char * start = a;
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	while (end - a >= 8) {
+		uint64_t x, y;
+
+		memcpy(&x, a, 8);
+		memcpy(&y, b, 8);
+		if (x != y) {
+			return (size_t)(a - start) + (size_t)(__builtin_ctzll(x ^ y) >> 3);
+		}
+		a += 8;
+		b += 8;
+	}
+#endif
+	while (a < end && *a == *b) {
+		a++;
+		b++;
+	}
+	return (size_t)(a - start);
+}
+
+static unsigned char *
+yasllzlength(unsigned char * op, size_t n) {
+	while (n >= 255) {
+		*op++ = 255;
+		n -= 255;
+	}
+	*op++ = (unsigned char)n;
+	return op;
+}
+
+/* Write a sequence of 'litlen' literals followed by a match, or no match if
+ * 'matchlen' is 0. */
+static unsigned char *
+yasllzsequence(unsigned char * op, const unsigned char * lit, size_t litlen, size_t offset, size_t matchlen) {
+	unsigned char * token = op++;
+
+	*token = (unsigned char)((litlen < 15 ? litlen : 15) << 4);
+	if (litlen >= 15) { op = yasllzlength(op, litlen - 15); }
+	memcpy(op, lit, litlen);
+	op += litlen;
+	if (matchlen) {
+		matchlen -= YASLLZ_MINMATCH;
+		*op++ = (unsigned char)(offset & 0xff);
+		*op++ = (unsigned char)(offset >> 8);
+		*token |= (unsigned char)(matchlen < 15 ? matchlen : 15);
+		if (matchlen >= 15) { op = yasllzlength(op, matchlen - 15); }
+	}
+	return op;
+}
+
+/* Compress 'base[start..end)' into 'out', which must have room for
+ * YASLLZ_BOUND(end - start) bytes. Matches may reach back to 'base[0]'. The
+ * hash table holds positions plus 'basepos', and positions below 'basepos'
+ * are stale, as is the initial 0 before that position was reached. Returns
+ * the compressed size. */
+static size_t
+yasllzblock(const unsigned char * base, size_t start, size_t end, size_t basepos, size_t * table, unsigned bits, unsigned char * out) {
+	size_t ip = start, anchor = start, ref, cand, len;
+	unsigned char * op = out;
+	unsigned misses = 1 << 6;
+
+	while (ip + YASLLZ_MINMATCH <= end) {
+		uint32_t seq = yasllzread32(base + ip);
+		size_t h = yasllzhash(seq, bits);
+
+		cand = table[h];
+		table[h] = basepos + ip;
+		if (cand < basepos || cand >= basepos + ip || basepos + ip - cand > YASLLZ_MAXOFFSET ||
+		    yasllzread32(base + cand - basepos) != seq) {
+			/* Skip ahead faster the longer nothing matches. */
+			ip += misses++ >> 6;
+			continue;
+		}
+		misses = 1 << 6;
+
+		ref = cand - basepos;
+		while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+			ip--;
+			ref--;
+		}
+		len = YASLLZ_MINMATCH + yasllzcommon(base + ip + YASLLZ_MINMATCH,
+		                                     base + ref + YASLLZ_MINMATCH, base + end);
+		op = yasllzsequence(op, base + anchor, ip - anchor, ip - ref, len);
+		ip += len;
+		anchor = ip;
+		if (ip + YASLLZ_MINMATCH - 2 <= end) {
+			table[yasllzhash(yasllzread32(base + ip - 2), bits)] = basepos + ip - 2;
+		}
+	}
+	op = yasllzsequence(op, base + anchor, end - anchor, 0, 0);
+	return (size_t)(op - out);
+}
+
+static int
+yasllzextra(const unsigned char ** ip, const unsigned char * iend, size_t * n) {
+	unsigned char b;
+
+	do {
+		if (*ip == iend || *n > SIZE_MAX - 255) { return -1; }
+		b = *(*ip)++;
+		*n += b;
+	} while (b == 255);
+	return 0;
+}
+
+/* Decompress 'len' bytes at 'src' into exactly 'outlen' bytes at 'out', where
+ * 'histlen' bytes of earlier output precede 'out'. If 'out' is NULL the input
+ * is only validated. Returns 0 on success and -1 on malformed input. */
+static inline int
+yasllzdecode(const unsigned char * src, size_t len, unsigned char * out, size_t outlen, size_t histlen) {
+	const unsigned char * ip = src, * iend = src + len;
+	size_t op = 0, n, offset;
+	unsigned token;
+
+	while (1) {
+		if (ip == iend) { return -1; }
+		token = *ip++;
+
+		n = token >> 4;
+		if (n == 15 && yasllzextra(&ip, iend, &n)) { return -1; }
+		if ((size_t)(iend - ip) < n || outlen - op < n) { return -1; }
+		if (out && n <= 16 && iend - ip >= 16 && outlen - op >= 16) {
+			/* Short literals are copied in one go when there is room. */
+			memcpy(out + op, ip, 16);
+		} else if (out) {
+			memcpy(out + op, ip, n);
+		}
+		ip += n;
+		op += n;
+		if (ip == iend) { break; }
+
+		if (iend - ip < 2) { return -1; }
+		offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+		ip += 2;
+		if (offset == 0 || offset > histlen + op) { return -1; }
+		n = token & 15;
+		if (n == 15 && yasllzextra(&ip, iend, &n)) { return -1; }
+		n += YASLLZ_MINMATCH;
+		if (outlen - op < n) { return -1; }
+
+		if (out && offset >= 16 && outlen - op >= n + 16) {
+			/* Far enough matches are copied 16 bytes at a time, which may
+			 * write past the end of the match but not of 'out'. */
+			for (size_t j = 0; j < n; j += 16) {
+				memcpy(out + op + j, out + op + j - offset, 16);
+			}
+		} else if (out) {
+			unsigned char * d = out + op;
+			const unsigned char * m = d - offset;
+			size_t left = n;
+
+			/* Overlapping matches repeat the bytes before them, and every
+			 * copy doubles the distance that can be copied at once. */
+			while (left) {
+				size_t c = (size_t)(d - m) < left ? (size_t)(d - m) : left;
+
+				memcpy(d, m, c);
+				d += c;
+				left -= c;
+			}
+		}
+		op += n;
+	}
+	return op == outlen ? 0 : -1;
+}
+
+static unsigned char *
+yasllzputvarint(unsigned char * p, size_t v) {
+	while (v >= 0x80) {
+		*p++ = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+/* Read a varint, returning the number of bytes it took, 0 if it is incomplete
+ * and -1 if it is malformed. */
+static int
+yasllzgetvarint(const unsigned char * p, const unsigned char * end, size_t * v) {
+	size_t n = 0;
+
+	*v = 0;
+	while (p + n < end) {
+		unsigned char b = p[n];
+
+		if (n * 7 >= sizeof(size_t) * 8 || (size_t)(b & 0x7f) > SIZE_MAX >> (n * 7)) {
+			return -1;
+		}
+		*v |= (size_t)(b & 0x7f) << (n * 7);
+		n++;
+		if (!(b & 0x80)) { return (int)n; }
+	}
+	return 0;
+}
+
+
+// Initialization //
+
+/* Create a stream for either compressing with yasllzcompress(), or for
+ * decompressing with yasllzdecompress(). */
+struct yasllz *
+yasllznew(void) {
+	struct yasllz * lz = calloc(1, sizeof(*lz));
+	if (!lz) { return NULL; }
+
+	lz->window = yaslempty();
+	lz->pending = yaslempty();
+	if (!lz->window || !lz->pending) {
+		yasllzfree(lz);
+		return NULL;
+	}
+	return lz;
+}
+
+
+// Querying //
+
+/* Return the original length recorded in the output of yaslcatlz(), or -1 if
+ * it is missing. */
+ptrdiff_t
+yasllzlen(const char * src, size_t len) {
+	if (!src) { return -1; }
+
+	size_t rawlen;
+
+	if (yasllzgetvarint((const unsigned char *)src, (const unsigned char *)src + len, &rawlen) <= 0 ||
+	    rawlen > PTRDIFF_MAX) {
+		return -1;
+	}
+	return (ptrdiff_t)rawlen;
+}
+
+/* Return whether yasllzdecompress() has seen the end of the stream. */
+int
+yasllzdone(const struct yasllz * lz) {
+	return lz && lz->state == 1;
+}
+
+
+// Concatenation //
+
+/* Append the 'len' bytes at 'src' compressed to 'dest', preceded by their
+ * original length. */
+yastr
+yaslcatlz(yastr dest, const void * src, size_t len) {
+	if (!dest || !src) { return NULL; }
+
+	size_t table[1 << YASLLZ_HASHBITS];
+	unsigned bits = 6;
+	unsigned char * p;
+
+	/* Small inputs use a smaller part of the table, which is cheaper to
+	 * clear. */
+	while (bits < YASLLZ_HASHBITS && ((size_t)1 << bits) < len / 4) {
+		bits++;
+	}
+	memset(table, 0, sizeof(size_t) << bits);
+
+	dest = yaslMakeRoomFor(dest, YASLLZ_VARINT + YASLLZ_BOUND(len));
+	if (!dest) { return NULL; }
+	p = yasllzputvarint((unsigned char *)dest + yasllen(dest), len);
+	p += yasllzblock(src, 0, len, 0, table, bits, p);
+	yaslIncrLen(dest, (size_t)(p - (unsigned char *)dest) - yasllen(dest));
+	return dest;
+}
+
+/* Append the data decompressed from the output of yaslcatlz() to 'dest'. The
+ * input is validated before 'dest' is grown or, if it is static, copied, so
+ * NULL is returned with 'dest' untouched if it is malformed. */
+yastr
+yaslcatunlz(yastr dest, const char * src, size_t len) {
+	if (!dest || !src) { return NULL; }
+
+	const unsigned char * p = (const unsigned char *)src;
+	size_t rawlen;
+	int n;
+
+	n = yasllzgetvarint(p, p + len, &rawlen);
+	if (n <= 0) { return NULL; }
+	p += n;
+	len -= (size_t)n;
+
+	/* With enough free space only the null terminator has to be restored if
+	 * the input turns out to be malformed, so it is decompressed right away.
+	 * Static strings are never written to, so they are copied first. */
+	if ((yaslheader(dest)->flags & YASL_STATIC) || yaslavail(dest) < rawlen) {
+		if (yasllzdecode(p, len, NULL, rawlen, 0)) { return NULL; }
+		dest = yaslMakeRoomFor(dest, rawlen);
+		if (!dest) { return NULL; }
+	}
+	if (yasllzdecode(p, len, (unsigned char *)dest + yasllen(dest), rawlen, 0)) {
+		dest[yasllen(dest)] = '\0';
+		return NULL;
+	}
+	yaslIncrLen(dest, rawlen);
+	return dest;
+}
+
+/* Compress the next 'len' bytes of a stream, appending the compressed blocks
+ * to 'dest'. Matches can refer back to the data of earlier calls. */
+yastr
+yasllzcompress(struct yasllz * lz, yastr dest, const void * src, size_t len) {
+	if (!lz || !dest || !src) { return NULL; }
+
+	const unsigned char * s = src;
+	size_t room = 0, block, histlen, complen;
+	unsigned char header[2 * YASLLZ_VARINT], * p, * hp;
+	yastr tmp;
+
+	for (size_t j = 0; j < len; j += YASLLZ_BLOCK) {
+		block = len - j < YASLLZ_BLOCK ? len - j : YASLLZ_BLOCK;
+		room += 2 * YASLLZ_VARINT + YASLLZ_BOUND(block);
+	}
+	/* The window holds at most YASLLZ_WINDOW bytes between blocks. */
+	tmp = yaslMakeRoomFor(lz->window, YASLLZ_WINDOW + (len < YASLLZ_BLOCK ? len : YASLLZ_BLOCK));
+	if (!tmp) { return NULL; }
+	lz->window = tmp;
+	dest = yaslMakeRoomFor(dest, room);
+	if (!dest) { return NULL; }
+
+	for (; len; s += block, len -= block) {
+		block = len < YASLLZ_BLOCK ? len : YASLLZ_BLOCK;
+		histlen = yasllen(lz->window);
+		memcpy(lz->window + histlen, s, block);
+		yaslIncrLen(lz->window, block);
+
+		/* The block is compressed past the longest possible header, and moved
+		 * down once its size is known. Blocks that do not compress are
+		 * stored, with a compressed size of 0. */
+		p = (unsigned char *)dest + yasllen(dest);
+		complen = yasllzblock((unsigned char *)lz->window, histlen, histlen + block,
+		                      lz->winpos, lz->table, YASLLZ_HASHBITS, p + sizeof(header));
+		if (complen >= block) {
+			complen = 0;
+			memcpy(p + sizeof(header), s, block);
+		}
+		hp = yasllzputvarint(header, block);
+		hp = yasllzputvarint(hp, complen);
+		memcpy(p, header, (size_t)(hp - header));
+		memmove(p + (hp - header), p + sizeof(header), complen ? complen : block);
+		yaslIncrLen(dest, (size_t)(hp - header) + (complen ? complen : block));
+
+		if (yasllen(lz->window) > YASLLZ_WINDOW) {
+			size_t drop = yasllen(lz->window) - YASLLZ_WINDOW;
+
+			lz->winpos += drop;
+			yaslrange(lz->window, (ptrdiff_t)drop, -1);
+		}
+	}
+	return dest;
+}
+
+/* Append the end of stream marker to 'dest'. */
+yastr
+yasllzfinish(struct yasllz * lz, yastr dest) {
+	if (!lz || !dest) { return NULL; }
+
+	return yaslcatlen(dest, "", 1);
+}
+
+/* Decompress the next 'len' bytes of a stream from yasllzcompress(), which
+ * may end anywhere, appending the data of every complete block to 'dest'. All
+ * complete blocks are validated before 'dest' is grown, so NULL is returned
+ * with 'dest' untouched if the stream is malformed or memory ran out, after
+ * which the stream cannot be used anymore. */
+yastr
+yasllzdecompress(struct yasllz * lz, yastr dest, const void * src, size_t len) {
+	if (!lz || !dest || !src || lz->state < 0) { return NULL; }
+
+	const unsigned char * start, * p, * end, * q;
+	size_t rawlen, complen, total = 0, maxraw = 0;
+	size_t pos = lz->winpos + yasllen(lz->window);
+	int ended = lz->state, n;
+	yastr tmp;
+
+	if (yasllen(lz->pending)) {
+		tmp = yaslcatlen(lz->pending, src, len);
+		if (!tmp) { goto fail; }
+		lz->pending = tmp;
+		src = lz->pending;
+		len = yasllen(lz->pending);
+	}
+	start = p = src;
+	end = p + len;
+
+	/* Validate every complete block first. */
+	while (p < end) {
+		q = p;
+		if (ended) { goto fail; }
+		if ((n = yasllzgetvarint(q, end, &rawlen)) < 0) { goto fail; }
+		if (n == 0) { break; }
+		q += n;
+		if (rawlen == 0) {
+			ended = 1;
+			p = q;
+			continue;
+		}
+		if (rawlen > YASLLZ_BLOCK) { goto fail; }
+		if ((n = yasllzgetvarint(q, end, &complen)) < 0) { goto fail; }
+		if (n == 0) { break; }
+		q += n;
+		if (complen >= rawlen) { goto fail; }
+		if ((size_t)(end - q) < (complen ? complen : rawlen)) { break; }
+		if (complen && yasllzdecode(q, complen, NULL, rawlen, pos + total)) { goto fail; }
+		total += rawlen;
+		if (rawlen > maxraw) { maxraw = rawlen; }
+		p = q + (complen ? complen : rawlen);
+	}
+
+	tmp = yaslMakeRoomFor(lz->window, YASLLZ_WINDOW + maxraw);
+	if (!tmp) { goto fail; }
+	lz->window = tmp;
+	if (start != (const unsigned char *)lz->pending) {
+		tmp = yaslMakeRoomFor(lz->pending, (size_t)(end - p));
+		if (!tmp) { goto fail; }
+		lz->pending = tmp;
+	}
+	tmp = yaslMakeRoomFor(dest, total);
+	if (!tmp) { goto fail; }
+	dest = tmp;
+
+	/* Then decompress them into the window, and copy them to 'dest'. */
+	for (q = start; q < p;) {
+		size_t histlen = yasllen(lz->window);
+
+		q += yasllzgetvarint(q, end, &rawlen);
+		if (rawlen == 0) {
+			lz->state = 1;
+			continue;
+		}
+		q += yasllzgetvarint(q, end, &complen);
+		if (complen) {
+			yasllzdecode(q, complen, (unsigned char *)lz->window + histlen, rawlen, histlen);
+		} else {
+			memcpy(lz->window + histlen, q, rawlen);
+		}
+		q += complen ? complen : rawlen;
+		yaslIncrLen(lz->window, rawlen);
+		memcpy(dest + yasllen(dest), lz->window + histlen, rawlen);
+		yaslIncrLen(dest, rawlen);
+
+		if (yasllen(lz->window) > YASLLZ_WINDOW) {
+			size_t drop = yasllen(lz->window) - YASLLZ_WINDOW;
+
+			lz->winpos += drop;
+			yaslrange(lz->window, (ptrdiff_t)drop, -1);
+		}
+	}
+
+	/* Keep the start of an incomplete block for the next call. */
+	if (start == (const unsigned char *)lz->pending) {
+		yaslrange(lz->pending, (ptrdiff_t)(p - start), -1);
+	} else {
+		memcpy(lz->pending, p, (size_t)(end - p));
+		yaslIncrLen(lz->pending, (size_t)(end - p));
+	}
+	return dest;
+
+fail:
+	lz->state = -1;
+	return NULL;
+}
+
+
+// Freeing //
+
+/* Free a compression or decompression stream. */
+void
+yasllzfree(struct yasllz * lz) {
+	if (!lz) { return; }
+
+	yaslfree(lz->window);
+	yaslfree(lz->pending);
+	free(lz);
+}
@@ -0,0 +1,484 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "yaslmap.h"
+
+/* Control bytes. A full slot holds the low 7 bits of the hash of its key. */
+#define YASLMAP_EMPTY 0x80
+#define YASLMAP_DELETED 0xFE
+
+#define YASLMAP_GROUP 16
+#define YASLMAP_MIGRATE 32           /* slots rehashed per modification */
+
+/* An open addressing table in the style of the Swiss tables of Abseil. Slots
+ * are probed in groups of 16, whose control bytes are compared at once. Each
+ * slot holds a key followed by its value. */
+struct yaslmaptable {
+	uint8_t * ctrl;
+	char * slots;
+	size_t mask;                 /* the number of groups minus one */
+	size_t used;                 /* full slots */
+	size_t growth;               /* empty slots that may still be filled */
+};
+
+/* While the map grows, the entries of the old table are moved to the new one
+ * a few at a time, on every modification, so that no single one of them
+ * rehashes the whole map. Lookups check both tables in the meantime. */
+struct yaslmap {
+	struct yaslmaptable cur;
+	struct yaslmaptable old;     /* old.ctrl is NULL unless growing */
+	size_t migrated;             /* the next slot of old to move */
+	size_t valsize;
+	size_t slotsize;
+	uint64_t seed;
+};
+
+
+// Low-level helper functions //
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 yaslu128;
+#endif
+
+/* Multiply 'a' and 'b' into 128 bits, returning the low half in 'a' and the
+ * high half in 'b'. */
+static inline void
+yaslmum(uint64_t * a, uint64_t * b) {
+#ifdef __SIZEOF_INT128__
+	yaslu128 r = (yaslu128)*a * *b;
+
+	*a = (uint64_t)r;
+	*b = (uint64_t)(r >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32), c = t < rl, lo = t + (rm1 << 32);
+
+	c += lo < t;
+	*a = lo;
+	*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t
+yaslmix(uint64_t a, uint64_t b) {
+	yaslmum(&a, &b);
+	return a ^ b;
+}
+
+static inline uint64_t
+yaslread64(const uint8_t * p) {
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t
+yaslread32(const uint8_t * p) {
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline unsigned
+yaslmapctz(unsigned mask) {
+#ifdef __GNUC__
+	return (unsigned)__builtin_ctz(mask);
+#else
+	unsigned n = 0;
+
+	while (!(mask & 1)) {
+		mask >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* The slots of the group at 'ctrl' whose control byte is 'c', as a bit mask. */
+static inline unsigned
+yaslmapmatch(const uint8_t * ctrl, uint8_t c) {
+#ifdef __SSE2__
+	__m128i g = _mm_loadu_si128((const __m128i *)(const void *)ctrl);
+
+	return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)c)));
+#else
+	unsigned mask = 0;
+
+	for (unsigned i = 0; i < YASLMAP_GROUP; i++) {
+		mask |= (unsigned)(ctrl[i] == c) << i;
+	}
+	return mask;
+#endif
+}
+
+/* The empty and deleted slots of the group at 'ctrl', which are the ones
+ * with the high bit of their control byte set. */
+static inline unsigned
+yaslmapvacant(const uint8_t * ctrl) {
+#ifdef __SSE2__
+	__m128i g = _mm_loadu_si128((const __m128i *)(const void *)ctrl);
+
+	return (unsigned)_mm_movemask_epi8(g);
+#else
+	unsigned mask = 0;
+
+	for (unsigned i = 0; i < YASLMAP_GROUP; i++) {
+		mask |= (unsigned)(ctrl[i] >> 7) << i;
+	}
+	return mask;
+#endif
+}
+
+static inline yastr
+yaslmapkey(const char * slot) {
+	yastr key;
+
+	memcpy(&key, slot, sizeof(key));
+	return key;
+}
+
+/* Return the slot holding 'key' in 't', or NULL. Groups are probed in
+ * triangular order, which visits every group of a power of two table, until
+ * one with an empty slot. */
+static char *
+yaslmapfind(const struct yaslmap * map, const struct yaslmaptable * t, const char * key, size_t len, uint64_t h) {
+	if (!t->ctrl) { return NULL; }
+
+	size_t g = (size_t)(h >> 7) & t->mask;
+
+	for (size_t step = 1; ; step++) {
+		const uint8_t * ctrl = t->ctrl + g * YASLMAP_GROUP;
+		unsigned mask = yaslmapmatch(ctrl, (uint8_t)(h & 0x7F));
+
+		while (mask) {
+			size_t i = g * YASLMAP_GROUP + yaslmapctz(mask);
+			char * slot = t->slots + i * map->slotsize;
+			yastr k = yaslmapkey(slot);
+
+			if (yasllen(k) == len && !memcmp(k, key, len)) { return slot; }
+			mask &= mask - 1;
+		}
+		if (yaslmapmatch(ctrl, YASLMAP_EMPTY)) { return NULL; }
+		g = (g + step) & t->mask;
+	}
+}
+
+/* Claim a slot for a key with hash 'h' that is not in 't'. */
+static char *
+yaslmapclaim(const struct yaslmap * map, struct yaslmaptable * t, uint64_t h) {
+	size_t g = (size_t)(h >> 7) & t->mask;
+
+	for (size_t step = 1; ; step++) {
+		unsigned mask = yaslmapvacant(t->ctrl + g * YASLMAP_GROUP);
+
+		if (mask) {
+			size_t i = g * YASLMAP_GROUP + yaslmapctz(mask);
+
+			if (t->ctrl[i] == YASLMAP_EMPTY) { t->growth--; }
+			t->ctrl[i] = (uint8_t)(h & 0x7F);
+			t->used++;
+			return t->slots + i * map->slotsize;
+		}
+		g = (g + step) & t->mask;
+	}
+}
+
+static int
+yaslmapinit(const struct yaslmap * map, struct yaslmaptable * t, size_t capacity) {
+	t->ctrl = malloc(capacity);
+	t->slots = malloc(capacity * map->slotsize);
+	if (!t->ctrl || !t->slots) {
+		free(t->ctrl);
+		free(t->slots);
+		t->ctrl = NULL;
+		return -1;
+	}
+	memset(t->ctrl, YASLMAP_EMPTY, capacity);
+	t->mask = capacity / YASLMAP_GROUP - 1;
+	t->used = 0;
+	t->growth = capacity / 8 * 7;
+	return 0;
+}
+
+/* Move the next few entries of the old table to the current one, and free
+ * the old table once it is empty. */
+static void
+yaslmapmigrate(struct yaslmap * map) {
+	struct yaslmaptable * old = &map->old;
+
+	if (!old->ctrl) { return; }
+
+	size_t capacity = (old->mask + 1) * YASLMAP_GROUP;
+	size_t end = map->migrated + YASLMAP_MIGRATE;
+
+	if (end > capacity) { end = capacity; }
+	for (size_t i = map->migrated; i < end && old->used; i++) {
+		if (old->ctrl[i] & 0x80) { continue; }
+
+		char * slot = old->slots + i * map->slotsize;
+		yastr key = yaslmapkey(slot);
+		uint64_t h = yaslhash(key, yasllen(key), map->seed);
+
+		memcpy(yaslmapclaim(map, &map->cur, h), slot, map->slotsize);
+		old->ctrl[i] = YASLMAP_DELETED;
+		old->used--;
+	}
+	map->migrated = end;
+	if (map->migrated == capacity || !old->used) {
+		free(old->ctrl);
+		free(old->slots);
+		old->ctrl = NULL;
+	}
+}
+
+/* Start moving the map into a new table, sized for twice its entries plus
+ * the ones that can be added before the move is complete. */
+static int
+yaslmapgrow(struct yaslmap * map) {
+	struct yaslmaptable t;
+	size_t capacity = YASLMAP_GROUP, need;
+
+	while (map->old.ctrl) { yaslmapmigrate(map); }
+	need = 2 * map->cur.used + (map->cur.mask + 1) * YASLMAP_GROUP / YASLMAP_MIGRATE + 1;
+	while (capacity / 8 * 7 < need) { capacity *= 2; }
+	if (yaslmapinit(map, &t, capacity)) { return -1; }
+
+	map->old = map->cur;
+	map->cur = t;
+	map->migrated = 0;
+	if (!map->old.used) {
+		free(map->old.ctrl);
+		free(map->old.slots);
+		map->old.ctrl = NULL;
+	}
+	return 0;
+}
+
+
+// Initialization //
+
+/* Create an empty map from yasl strings to values of 'valsize' bytes, which
+ * are aligned like pointers. For values that are pointers, pass
+ * sizeof(void *). */
+struct yaslmap *
+yaslmapnew(size_t valsize) {
+	struct yaslmap * map = calloc(1, sizeof(*map));
+	if (!map) { return NULL; }
+
+	map->valsize = valsize;
+	map->slotsize = sizeof(yastr) + (valsize + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+	map->seed = (uint64_t)(uintptr_t)map * UINT64_C(0x9E3779B97F4A7C15);
+	if (yaslmapinit(map, &map->cur, YASLMAP_GROUP)) {
+		free(map);
+		return NULL;
+	}
+	return map;
+}
+
+
+// Querying //
+
+/* Hash 'len' bytes at 'src' into 64 bits, with an algorithm in the style of
+ * wyhash, which mixes 16 bytes at a time with 128 bit multiplications. */
+uint64_t
+yaslhash(const void * src, size_t len, uint64_t seed) {
+	static const uint64_t k[4] = {
+		UINT64_C(0xa0761d6478bd642f), UINT64_C(0xe7037ed1a0b428db),
+		UINT64_C(0x8ebc6af09c88c6e3), UINT64_C(0x589965cc75374cc3)
+	};
+	const uint8_t * p = src;
+	uint64_t a, b;
+
+	seed ^= yaslmix(seed ^ k[0], k[1]);
+	if (len <= 16) {
+		if (len >= 4) {
+			size_t mid = (len >> 3) << 2;
+
+			a = (yaslread32(p) << 32) | yaslread32(p + mid);
+			b = (yaslread32(p + len - 4) << 32) | yaslread32(p + len - 4 - mid);
+		} else if (len) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+
+		if (i > 48) {
+			uint64_t seed1 = seed, seed2 = seed;
+
+			do {
+				seed = yaslmix(yaslread64(p) ^ k[1], yaslread64(p + 8) ^ seed);
+				seed1 = yaslmix(yaslread64(p + 16) ^ k[2], yaslread64(p + 24) ^ seed1);
+				seed2 = yaslmix(yaslread64(p + 32) ^ k[3], yaslread64(p + 40) ^ seed2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while (i > 16) {
+			seed = yaslmix(yaslread64(p) ^ k[1], yaslread64(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		a = yaslread64(p + i - 16);
+		b = yaslread64(p + i - 8);
+	}
+	a ^= k[1];
+	b ^= seed;
+	yaslmum(&a, &b);
+	return yaslmix(a ^ k[0] ^ len, b ^ k[1]);
+}
+
+/* Return a pointer to the value of the key 'key' of length 'len', or NULL if
+ * it is not in the map. The key is compared by length first, so it can be a
+ * yasl string, or any other bytes. */
+void *
+yaslmapget(const struct yaslmap * map, const char * key, size_t len) {
+	if (!map || (!key && len)) { return NULL; }
+
+	uint64_t h = yaslhash(key, len, map->seed);
+	char * slot = yaslmapfind(map, &map->cur, key, len, h);
+
+	if (!slot) { slot = yaslmapfind(map, &map->old, key, len, h); }
+	return slot ? slot + sizeof(yastr) : NULL;
+}
+
+/* Return the number of entries in the map. */
+size_t
+yaslmapcount(const struct yaslmap * map) {
+	if (!map) { return 0; }
+
+	return map->cur.used + (map->old.ctrl ? map->old.used : 0);
+}
+
+/* Iterate over the entries of the map, in no particular order. '*iter' must
+ * be 0 before the first call. Each call stores the next key and a pointer to
+ * its value in '*key' and '*value', unless they are NULL, and returns 0, or
+ * -1 once all entries have been visited. The map must not be modified in the
+ * meantime. */
+int
+yaslmapnext(const struct yaslmap * map, size_t * iter, yastr * key, void ** value) {
+	if (!map || !iter) { return -1; }
+
+	size_t curcap = (map->cur.mask + 1) * YASLMAP_GROUP;
+	size_t oldcap = map->old.ctrl ? (map->old.mask + 1) * YASLMAP_GROUP : 0;
+
+	for (; *iter < curcap + oldcap; (*iter)++) {
+		const struct yaslmaptable * t = *iter < curcap ? &map->cur : &map->old;
+		size_t i = *iter < curcap ? *iter : *iter - curcap;
+
+		if (t->ctrl[i] & 0x80) { continue; }
+
+		char * slot = t->slots + i * map->slotsize;
+
+		if (key) { *key = yaslmapkey(slot); }
+		if (value) { *value = slot + sizeof(yastr); }
+		(*iter)++;
+		return 0;
+	}
+	return -1;
+}
+
+
+// Modification //
+
+/* Return a pointer to the value of the key 'key' of length 'len', inserting
+ * the key with a zeroed value if it is not in the map yet. The map keeps its
+ * own copy of the key. The pointer is valid until the next modification of
+ * the map. Returns NULL on out of memory. */
+void *
+yaslmapput(struct yaslmap * map, const char * key, size_t len) {
+	if (!map || (!key && len)) { return NULL; }
+
+	uint64_t h = yaslhash(key, len, map->seed);
+	char * slot;
+	yastr k;
+
+	yaslmapmigrate(map);
+	slot = yaslmapfind(map, &map->cur, key, len, h);
+	if (!slot) { slot = yaslmapfind(map, &map->old, key, len, h); }
+	if (slot) { return slot + sizeof(yastr); }
+
+	if (!map->cur.growth && yaslmapgrow(map)) { return NULL; }
+	k = yaslnew(key, len);
+	if (!k) { return NULL; }
+	slot = yaslmapclaim(map, &map->cur, h);
+	memcpy(slot, &k, sizeof(k));
+	memset(slot + sizeof(yastr), 0, map->slotsize - sizeof(yastr));
+	return slot + sizeof(yastr);
+}
+
+/* Remove the key 'key' of length 'len' from the map. Returns 0, or -1 if the
+ * key is not in the map. */
+int
+yaslmapdel(struct yaslmap * map, const char * key, size_t len) {
+	if (!map || (!key && len)) { return -1; }
+
+	uint64_t h = yaslhash(key, len, map->seed);
+	struct yaslmaptable * t = &map->cur;
+	char * slot;
+	size_t i;
+
+	yaslmapmigrate(map);
+	slot = yaslmapfind(map, t, key, len, h);
+	if (!slot) {
+		t = &map->old;
+		slot = yaslmapfind(map, t, key, len, h);
+	}
+	if (!slot) { return -1; }
+
+	yaslfree(yaslmapkey(slot));
+	i = (size_t)(slot - t->slots) / map->slotsize;
+	/* A probe only stops at a group with an empty slot, so if the group has
+	 * one already, this slot can become empty too instead of a tombstone. */
+	if (yaslmapmatch(t->ctrl + i / YASLMAP_GROUP * YASLMAP_GROUP, YASLMAP_EMPTY)) {
+		t->ctrl[i] = YASLMAP_EMPTY;
+		t->growth++;
+	} else {
+		t->ctrl[i] = YASLMAP_DELETED;
+	}
+	t->used--;
+	return 0;
+}
+
+
+// Freeing //
+
+/* Free a map and all its keys. No operation is performed if 'map' is NULL. */
+void
+yaslmapfree(struct yaslmap * map) {
+	if (!map) { return; }
+
+	struct yaslmaptable * tables[2] = { &map->cur, &map->old };
+
+	for (size_t j = 0; j < 2; j++) {
+		struct yaslmaptable * t = tables[j];
+
+		if (!t->ctrl) { continue; }
+		for (size_t i = 0; i < (t->mask + 1) * YASLMAP_GROUP; i++) {
+			if (!(t->ctrl[i] & 0x80)) { yaslfree(yaslmapkey(t->slots + i * map->slotsize)); }
+		}
+		free(t->ctrl);
+		free(t->slots);
+	}
+	free(map);
+}
@@ -0,0 +1,668 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "yaslrax.h"
+
+/* Node layouts, chosen by the number of children like in the adaptive radix
+ * tree of Leis et al, so that small nodes stay small and large ones find a
+ * child with a single load. */
+enum {
+	YASLRAX_LEAF,                /* no children */
+	YASLRAX_NODE4,               /* up to 4 children, with sorted bytes */
+	YASLRAX_NODE16,              /* up to 16 children, with sorted bytes */
+	YASLRAX_NODE48,              /* up to 48 children, indexed by byte */
+	YASLRAX_NODE256              /* a child for every byte */
+};
+
+/* The number of children of each layout, and the bytes of its index. */
+static const size_t yaslraxcap[] = { 0, 4, 16, 48, 256 };
+static const size_t yaslraxindex[] = { 0, 4, 16, 256, 0 };
+
+/* A node of a compressed radix tree. The key of a node is the key of its
+ * parent, followed by the byte of the node in its parent and by the path of
+ * the node, so chains of nodes with a single child are merged into one. A
+ * node is allocated in one block: this header, the pointers to its children,
+ * the index of their bytes, and its path. */
+struct yaslraxnode {
+	void * value;
+	uint32_t plen;               /* the length of the path */
+	uint16_t count;              /* the number of children */
+	uint8_t type;
+	uint8_t iskey;
+};
+
+struct yaslrax {
+	struct yaslraxnode * root;
+	size_t count;
+};
+
+/* A node on the path of an iterator. */
+struct yaslraxframe {
+	const struct yaslraxnode * node;
+	size_t keylen;               /* the length of the key of the node */
+	int next;                    /* the next child byte, -1 for the node */
+};
+
+
+// Low-level helper functions //
+
+static inline struct yaslraxnode **
+yaslraxchildren(const struct yaslraxnode * n) {
+	return (struct yaslraxnode **)(void *)(n + 1);
+}
+
+static inline uint8_t *
+yaslraxkeys(const struct yaslraxnode * n) {
+	return (uint8_t *)(yaslraxchildren(n) + yaslraxcap[n->type]);
+}
+
+static inline uint8_t *
+yaslraxpath(const struct yaslraxnode * n) {
+	return yaslraxkeys(n) + yaslraxindex[n->type];
+}
+
+static inline unsigned
+yaslraxctz(unsigned mask) {
+#ifdef __GNUC__
+	return (unsigned)__builtin_ctz(mask);
+#else
+	unsigned n = 0;
+
+	while (!(mask & 1)) {
+		mask >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/* Allocate a node without children, with room for a path of 'plen' bytes
+ * which the caller fills in. */
+static struct yaslraxnode *
+yaslraxalloc(uint8_t type, size_t plen) {
+	size_t head = sizeof(struct yaslraxnode) + yaslraxcap[type] * sizeof(struct yaslraxnode *) + yaslraxindex[type];
+	struct yaslraxnode * n = malloc(head + plen);
+	if (!n) { return NULL; }
+
+	memset(n, 0, head);
+	n->plen = (uint32_t)plen;
+	n->type = type;
+	return n;
+}
+
+/* Copy 'n' and its children, with room for a path of 'plen' bytes which the
+ * caller fills in. */
+static struct yaslraxnode *
+yaslraxcopy(const struct yaslraxnode * n, size_t plen) {
+	struct yaslraxnode * m = yaslraxalloc(n->type, plen);
+	if (!m) { return NULL; }
+
+	memcpy(m, n, (size_t)(yaslraxpath(n) - (const uint8_t *)n));
+	m->plen = (uint32_t)plen;
+	return m;
+}
+
+/* Return the slot of the child of 'n' for the byte 'c', or NULL. */
+static struct yaslraxnode **
+yaslraxchild(const struct yaslraxnode * n, uint8_t c) {
+	struct yaslraxnode ** children = yaslraxchildren(n);
+	const uint8_t * keys = yaslraxkeys(n);
+
+	switch (n->type) {
+	case YASLRAX_NODE16:
+#ifdef __SSE2__
+		{
+			__m128i k = _mm_loadu_si128((const __m128i *)(const void *)keys);
+			unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(k, _mm_set1_epi8((char)c)));
+
+			mask &= (1u << n->count) - 1;
+			return mask ? children + yaslraxctz(mask) : NULL;
+		}
+#endif
+		/* fall through */
+	case YASLRAX_NODE4:
+		for (unsigned i = 0; i < n->count && keys[i] <= c; i++) {
+			if (keys[i] == c) { return children + i; }
+		}
+		return NULL;
+	case YASLRAX_NODE48:
+		return keys[c] ? children + keys[c] - 1 : NULL;
+	case YASLRAX_NODE256:
+		return children[c] ? children + c : NULL;
+	}
+	return NULL;
+}
+
+/* Return the child of 'n' with the smallest byte not below 'from', storing
+ * its byte in '*c', or NULL. */
+static struct yaslraxnode *
+yaslraxnextchild(const struct yaslraxnode * n, unsigned from, unsigned * c) {
+	struct yaslraxnode ** children = yaslraxchildren(n);
+	const uint8_t * keys = yaslraxkeys(n);
+
+	switch (n->type) {
+	case YASLRAX_NODE4:
+	case YASLRAX_NODE16:
+		for (unsigned i = 0; i < n->count; i++) {
+			if (keys[i] >= from) {
+				*c = keys[i];
+				return children[i];
+			}
+		}
+		break;
+	case YASLRAX_NODE48:
+		for (unsigned b = from; b < 256; b++) {
+			if (keys[b]) {
+				*c = b;
+				return children[keys[b] - 1];
+			}
+		}
+		break;
+	case YASLRAX_NODE256:
+		for (unsigned b = from; b < 256; b++) {
+			if (children[b]) {
+				*c = b;
+				return children[b];
+			}
+		}
+		break;
+	}
+	return NULL;
+}
+
+/* Add 'child' for the byte 'c' to 'n', which must have room for it. */
+static void
+yaslraxattach(struct yaslraxnode * n, uint8_t c, struct yaslraxnode * child) {
+	struct yaslraxnode ** children = yaslraxchildren(n);
+	uint8_t * keys = yaslraxkeys(n);
+	unsigned i;
+
+	switch (n->type) {
+	case YASLRAX_NODE4:
+	case YASLRAX_NODE16:
+		for (i = n->count; i && keys[i - 1] > c; i--) {}
+		memmove(keys + i + 1, keys + i, n->count - i);
+		memmove(children + i + 1, children + i, (n->count - i) * sizeof(*children));
+		keys[i] = c;
+		children[i] = child;
+		break;
+	case YASLRAX_NODE48:
+		for (i = 0; children[i]; i++) {}
+		children[i] = child;
+		keys[c] = (uint8_t)(i + 1);
+		break;
+	case YASLRAX_NODE256:
+		children[c] = child;
+		break;
+	}
+	n->count++;
+}
+
+/* Remove the child for the byte 'c' from 'n'. */
+static void
+yaslraxdetach(struct yaslraxnode * n, uint8_t c) {
+	struct yaslraxnode ** children = yaslraxchildren(n);
+	uint8_t * keys = yaslraxkeys(n);
+	unsigned i;
+
+	switch (n->type) {
+	case YASLRAX_NODE4:
+	case YASLRAX_NODE16:
+		for (i = 0; keys[i] != c; i++) {}
+		memmove(keys + i, keys + i + 1, n->count - i - 1);
+		memmove(children + i, children + i + 1, (n->count - i - 1) * sizeof(*children));
+		break;
+	case YASLRAX_NODE48:
+		children[keys[c] - 1] = NULL;
+		keys[c] = 0;
+		break;
+	case YASLRAX_NODE256:
+		children[c] = NULL;
+		break;
+	}
+	n->count--;
+}
+
+/* Replace the node in '*slot' with one of another layout. */
+static int
+yaslraxresize(struct yaslraxnode ** slot, uint8_t type) {
+	struct yaslraxnode * n = *slot, * m = yaslraxalloc(type, n->plen), * child;
+	unsigned c = 0;
+	if (!m) { return -1; }
+
+	m->value = n->value;
+	m->iskey = n->iskey;
+	memcpy(yaslraxpath(m), yaslraxpath(n), n->plen);
+	for (child = yaslraxnextchild(n, 0, &c); child; child = yaslraxnextchild(n, c + 1, &c)) {
+		yaslraxattach(m, (uint8_t)c, child);
+	}
+	free(n);
+	*slot = m;
+	return 0;
+}
+
+/* Split the path of the node in '*slot' after 'i' bytes, into a new node
+ * with the rest of the node as its only child. */
+static int
+yaslraxsplit(struct yaslraxnode ** slot, size_t i) {
+	struct yaslraxnode * n = *slot;
+	const uint8_t * path = yaslraxpath(n);
+	struct yaslraxnode * head = yaslraxalloc(YASLRAX_NODE4, i);
+	struct yaslraxnode * rest = yaslraxcopy(n, n->plen - i - 1);
+
+	if (!head || !rest) {
+		free(head);
+		free(rest);
+		return -1;
+	}
+	memcpy(yaslraxpath(head), path, i);
+	memcpy(yaslraxpath(rest), path + i + 1, rest->plen);
+	yaslraxattach(head, path[i], rest);
+	free(n);
+	*slot = head;
+	return 0;
+}
+
+/* Restore the shape of the tree after the node in '*slot' lost its key or a
+ * child: merge it with its only child if it is not a key, or move it to a
+ * smaller layout once it is at most three quarters full. Running out of
+ * memory here only leaves the tree less compact. */
+static void
+yaslraxtidy(struct yaslraxnode ** slot, int isroot) {
+	struct yaslraxnode * n = *slot;
+
+	if (!isroot && !n->iskey && n->count == 1) {
+		unsigned c;
+		struct yaslraxnode * child = yaslraxnextchild(n, 0, &c);
+		struct yaslraxnode * m = yaslraxcopy(child, (size_t)n->plen + 1 + child->plen);
+		if (!m) { return; }
+
+		uint8_t * path = yaslraxpath(m);
+
+		memcpy(path, yaslraxpath(n), n->plen);
+		path[n->plen] = (uint8_t)c;
+		memcpy(path + n->plen + 1, yaslraxpath(child), child->plen);
+		free(n);
+		free(child);
+		*slot = m;
+	} else if (n->type != YASLRAX_LEAF && n->count <= yaslraxcap[n->type - 1] / 4 * 3) {
+		yaslraxresize(slot, (uint8_t)(n->type - 1));
+	}
+}
+
+/* Return the node whose key is 'key', or NULL. */
+static struct yaslraxnode *
+yaslraxfind(const struct yaslrax * rax, const char * key, size_t len) {
+	struct yaslraxnode * n = rax->root;
+	size_t pos = 0;
+
+	for (;;) {
+		if (n->plen > len - pos || memcmp(yaslraxpath(n), key + pos, n->plen)) { return NULL; }
+		pos += n->plen;
+		if (pos == len) { return n; }
+
+		struct yaslraxnode ** child = yaslraxchild(n, (uint8_t)key[pos++]);
+
+		if (!child) { return NULL; }
+		n = *child;
+	}
+}
+
+/* Truncate 'str' to 'len' bytes. */
+static void
+yaslraxtrunc(yastr str, size_t len) {
+	if (len) {
+		yaslrange(str, 0, (ptrdiff_t)len - 1);
+	} else {
+		yaslclear(str);
+	}
+}
+
+/* Descend into 'n' through the byte 'c', or -1 for the root: set the key to
+ * the key of 'n' and push 'n' on the stack of the iterator. */
+static int
+yaslraxenter(struct yaslraxiter * it, const struct yaslraxnode * n, int c, int next) {
+	char byte = (char)c;
+
+	if (it->depth == it->size) {
+		size_t size = it->size ? it->size * 2 : 16;
+		struct yaslraxframe * stack = realloc(it->stack, size * sizeof(*stack));
+		if (!stack) { return -1; }
+
+		it->stack = stack;
+		it->size = size;
+	}
+	yaslraxtrunc(it->key, it->depth ? it->stack[it->depth - 1].keylen : 0);
+	if (c >= 0) {
+		yastr key = yaslcatlen(it->key, &byte, 1);
+		if (!key) { return -1; }
+		it->key = key;
+	}
+	if (n->plen) {
+		yastr key = yaslcatlen(it->key, yaslraxpath(n), n->plen);
+		if (!key) { return -1; }
+		it->key = key;
+	}
+	it->stack[it->depth].node = n;
+	it->stack[it->depth].keylen = yasllen(it->key);
+	it->stack[it->depth].next = next;
+	it->depth++;
+	return 0;
+}
+
+/* Follow 'key' down the tree, leaving on the stack of the iterator the nodes
+ * that hold the keys to visit: the ones not below 'key', or the ones that
+ * start with it if 'prefix' is set. */
+static int
+yaslraxdescend(struct yaslraxiter * it, const char * key, size_t len, int prefix) {
+	if (!it || !it->rax || (!key && len)) { return -1; }
+
+	const struct yaslraxnode * n = it->rax->root;
+	size_t pos = 0;
+	int c = -1;
+
+	it->depth = 0;
+	if (!it->key && !(it->key = yaslempty())) { return -1; }
+	for (;;) {
+		const uint8_t * path = yaslraxpath(n);
+		size_t i = 0;
+
+		while (i < n->plen && pos + i < len && path[i] == (uint8_t)key[pos + i]) { i++; }
+		if (yaslraxenter(it, n, c, -1)) { return -1; }
+		if (i < n->plen) {
+			/* The key ends or differs within the path, so all keys under
+			 * 'n' come after it, or all come before it. */
+			if (pos + i < len && (prefix || path[i] < (uint8_t)key[pos + i])) { it->depth--; }
+			return 0;
+		}
+		pos += i;
+		if (pos == len) { return 0; }
+
+		struct yaslraxnode ** child = yaslraxchild(n, (uint8_t)key[pos]);
+
+		it->stack[it->depth - 1].next = prefix ? 256 : (uint8_t)key[pos] + 1;
+		if (!child) { return 0; }
+		n = *child;
+		c = (uint8_t)key[pos++];
+	}
+}
+
+
+// Initialization //
+
+/* Create an empty compressed radix tree, which maps keys to pointers and
+ * keeps them in lexicographic order. */
+struct yaslrax *
+yaslraxnew(void) {
+	struct yaslrax * rax = malloc(sizeof(*rax));
+	if (!rax) { return NULL; }
+
+	rax->root = yaslraxalloc(YASLRAX_LEAF, 0);
+	if (!rax->root) {
+		free(rax);
+		return NULL;
+	}
+	rax->count = 0;
+	return rax;
+}
+
+/* Initialize an iterator over the keys of 'rax', which is positioned with
+ * yaslraxseek() or yaslraxprefix() and freed with yaslraxiterfree(). */
+void
+yaslraxiterinit(struct yaslraxiter * it, const struct yaslrax * rax) {
+	if (!it) { return; }
+
+	it->key = NULL;
+	it->value = NULL;
+	it->rax = rax;
+	it->stack = NULL;
+	it->depth = 0;
+	it->size = 0;
+}
+
+
+// Querying //
+
+/* Return a pointer to the value of the key 'key' of length 'len', or NULL if
+ * it is not in the tree. */
+void **
+yaslraxget(const struct yaslrax * rax, const char * key, size_t len) {
+	if (!rax || (!key && len)) { return NULL; }
+
+	struct yaslraxnode * n = yaslraxfind(rax, key, len);
+
+	return n && n->iskey ? &n->value : NULL;
+}
+
+/* Return the number of keys in the tree. */
+size_t
+yaslraxcount(const struct yaslrax * rax) {
+	return rax ? rax->count : 0;
+}
+
+/* Position the iterator before the first key that is not smaller than 'key'
+ * of length 'len'. Returns 0, or -1 on out of memory. */
+int
+yaslraxseek(struct yaslraxiter * it, const char * key, size_t len) {
+	return yaslraxdescend(it, key, len, 0);
+}
+
+/* Position the iterator before the first key that starts with 'prefix' of
+ * length 'len', and stop it after the last one. Returns 0, or -1 on out of
+ * memory. */
+int
+yaslraxprefix(struct yaslraxiter * it, const char * prefix, size_t len) {
+	return yaslraxdescend(it, prefix, len, 1);
+}
+
+/* Move the iterator to the next key, and store it and its value in 'it->key'
+ * and 'it->value'. Returns 0, or -1 once all keys have been visited or on out
+ * of memory. The tree must not be modified while iterating over it. */
+int
+yaslraxnext(struct yaslraxiter * it) {
+	if (!it) { return -1; }
+
+	while (it->depth) {
+		struct yaslraxframe * f = &it->stack[it->depth - 1];
+		struct yaslraxnode * child;
+		unsigned c;
+
+		if (f->next < 0) {
+			f->next = 0;
+			if (f->node->iskey) {
+				yaslraxtrunc(it->key, f->keylen);
+				it->value = f->node->value;
+				return 0;
+			}
+			continue;
+		}
+		child = f->next < 256 ? yaslraxnextchild(f->node, (unsigned)f->next, &c) : NULL;
+		if (!child) {
+			it->depth--;
+			continue;
+		}
+		f->next = (int)c + 1;
+		if (yaslraxenter(it, child, (int)c, -1)) { return -1; }
+	}
+	return -1;
+}
+
+
+// Modification //
+
+/* Return a pointer to the value of the key 'key' of length 'len', inserting
+ * the key with a NULL value if it is not in the tree yet. The pointer is
+ * valid until the next modification of the tree. Returns NULL on out of
+ * memory, or if the key is longer than 4 GiB. */
+void **
+yaslraxput(struct yaslrax * rax, const char * key, size_t len) {
+	if (!rax || (!key && len) || len > UINT32_MAX) { return NULL; }
+
+	struct yaslraxnode ** slot = &rax->root;
+	size_t pos = 0;
+
+	for (;;) {
+		struct yaslraxnode * n = *slot, * leaf, ** child;
+		const uint8_t * path = yaslraxpath(n);
+		size_t i = 0;
+
+		while (i < n->plen && pos + i < len && path[i] == (uint8_t)key[pos + i]) { i++; }
+		if (i < n->plen) {
+			if (yaslraxsplit(slot, i)) { return NULL; }
+			n = *slot;
+		}
+		pos += i;
+		if (pos == len) {
+			if (!n->iskey) {
+				n->iskey = 1;
+				n->value = NULL;
+				rax->count++;
+			}
+			return &n->value;
+		}
+
+		child = yaslraxchild(n, (uint8_t)key[pos]);
+		if (child) {
+			slot = child;
+			pos++;
+			continue;
+		}
+
+		leaf = yaslraxalloc(YASLRAX_LEAF, len - pos - 1);
+		if (!leaf) { return NULL; }
+		if (n->count == yaslraxcap[n->type] && yaslraxresize(slot, (uint8_t)(n->type + 1))) {
+			free(leaf);
+			return NULL;
+		}
+		memcpy(yaslraxpath(leaf), key + pos + 1, leaf->plen);
+		leaf->iskey = 1;
+		yaslraxattach(*slot, (uint8_t)key[pos], leaf);
+		rax->count++;
+		return &leaf->value;
+	}
+}
+
+/* Remove the key 'key' of length 'len' from the tree, and store its value
+ * in '*value' unless it is NULL. Returns 0, or -1 if the key is not in the
+ * tree. */
+int
+yaslraxdel(struct yaslrax * rax, const char * key, size_t len, void ** value) {
+	if (!rax || (!key && len)) { return -1; }
+
+	struct yaslraxnode ** slot = &rax->root, ** parent = NULL;
+	/* The first of the nodes right above the one of the key that are neither
+	 * keys nor have other children, which go away with it, and its parent. */
+	struct yaslraxnode ** chain = NULL, ** chainparent = NULL;
+	uint8_t c = 0, chainc = 0;
+	size_t pos = 0;
+	struct yaslraxnode * n;
+
+	for (;;) {
+		n = *slot;
+		if (n->plen > len - pos || memcmp(yaslraxpath(n), key + pos, n->plen)) { return -1; }
+		pos += n->plen;
+		if (pos == len) { break; }
+
+		struct yaslraxnode ** child = yaslraxchild(n, (uint8_t)key[pos]);
+
+		if (!child) { return -1; }
+		if (parent && !n->iskey && n->count == 1) {
+			if (!chain) {
+				chain = slot;
+				chainparent = parent;
+				chainc = c;
+			}
+		} else {
+			chain = NULL;
+		}
+		parent = slot;
+		c = (uint8_t)key[pos++];
+		slot = child;
+	}
+	if (!n->iskey) { return -1; }
+
+	if (value) { *value = n->value; }
+	n->iskey = 0;
+	n->value = NULL;
+	rax->count--;
+	if (!parent) { return 0; }
+
+	if (n->count) {
+		yaslraxtidy(slot, 0);
+	} else {
+		struct yaslraxnode * x;
+
+		if (chain) {
+			slot = chain;
+			parent = chainparent;
+			c = chainc;
+		}
+		x = *slot;
+		yaslraxdetach(*parent, c);
+		while (x) {
+			unsigned b;
+			struct yaslraxnode * next = x->count ? yaslraxnextchild(x, 0, &b) : NULL;
+
+			free(x);
+			x = next;
+		}
+		yaslraxtidy(parent, parent == &rax->root);
+	}
+	return 0;
+}
+
+
+// Freeing //
+
+/* Free a tree and all its nodes, but not the values of its keys. No
+ * operation is performed if 'rax' is NULL. */
+void
+yaslraxfree(struct yaslrax * rax) {
+	if (!rax) { return; }
+
+	struct yaslraxnode * n = rax->root;
+
+	/* Walk down without a stack, keeping the parent of each node in its
+	 * value, and free the nodes on the way back up. */
+	n->value = NULL;
+	while (n) {
+		unsigned c;
+		struct yaslraxnode * child = n->count ? yaslraxnextchild(n, 0, &c) : NULL;
+
+		if (child) {
+			yaslraxdetach(n, (uint8_t)c);
+			child->value = n;
+			n = child;
+		} else {
+			struct yaslraxnode * up = n->value;
+
+			free(n);
+			n = up;
+		}
+	}
+	free(rax);
+}
+
+/* Free the key and the stack of an iterator. */
+void
+yaslraxiterfree(struct yaslraxiter * it) {
+	if (!it) { return; }
+
+	yaslfree(it->key);
+	free(it->stack);
+	yaslraxiterinit(it, it->rax);
+}
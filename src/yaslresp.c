@@ -0,0 +1,271 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "yaslresp.h"
+
+/* The longest decimal representation of a long long, with its sign. */
+#define YASLRESP_DIGITS 20
+
+
+// Low-level helper functions //
+
+/* Parse the decimal integer 'p' of length 'len' into '*value'. Returns 0, or
+ * -1 if it is malformed or out of range. */
+static int
+yaslrespnum(const char * p, size_t len, long long * value) {
+	unsigned long long v = 0, limit = LLONG_MAX;
+	int neg = len && *p == '-';
+
+	if (neg) {
+		p++;
+		len--;
+		limit++;
+	}
+	if (!len || len > YASLRESP_DIGITS) { return -1; }
+	for (size_t i = 0; i < len; i++) {
+		unsigned d = (unsigned)(unsigned char)p[i] - '0';
+
+		if (d > 9 || v > (limit - d) / 10) { return -1; }
+		v = v * 10 + d;
+	}
+	/* Negate without overflowing for LLONG_MIN. */
+	*value = neg && v ? -(long long)(v - 1) - 1 : (long long)v;
+	return 0;
+}
+
+/* Account for a value that was parsed completely, and for the aggregates it
+ * completes. Attributes do not count as values of their parent. */
+static void
+yaslrespdone(struct yaslresp * resp) {
+	while (resp->depth) {
+		size_t level = resp->depth - 1;
+		uint32_t bit = UINT32_C(1) << level;
+
+		if (--resp->left[level]) { return; }
+		resp->depth--;
+		if (resp->attrs & bit) {
+			resp->attrs &= ~bit;
+			return;
+		}
+	}
+}
+
+/* The number of decimal digits of 'value', with its sign. */
+static size_t
+yaslrespdigits(long long value) {
+	unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+	size_t n = value < 0 ? 2 : 1;
+
+	while (v >= 10) {
+		v /= 10;
+		n++;
+	}
+	return n;
+}
+
+
+// Initialization //
+
+/* Initialize a parser, to parse a buffer from its start. */
+void
+yaslrespinit(struct yaslresp * resp) {
+	if (!resp) { return; }
+
+	resp->pos = 0;
+	resp->depth = 0;
+	resp->attrs = 0;
+}
+
+
+// Querying //
+
+/* Parse the next RESP2 or RESP3 value of 'buf' of length 'len', starting at
+ * 'resp->pos', into 'val', and move 'resp->pos' past it. Returns 1 if a value
+ * was parsed, 0 if the buffer ends before the value does, and -1 if it is
+ * not valid RESP. Nothing is consumed unless a value is parsed, so parsing
+ * resumes once more bytes have been appended to the buffer.
+ *
+ * Strings, errors, doubles and big numbers are returned in 'val->str' and
+ * 'val->len', pointing into 'buf' without copying them, so they are only
+ * valid until it is modified; yaslnew() copies them. Integers and booleans
+ * are returned in 'val->num'. Aggregates are returned as their size in
+ * 'val->num', the number of pairs for maps and attributes, followed by their
+ * values one by one, and 'resp->depth' is the number of aggregates that are
+ * not complete yet: it is 0 after a whole value. Null bulk strings and arrays
+ * of RESP2 are returned as nulls, of type '_'. Streamed strings and
+ * aggregates of RESP3 are not supported. */
+int
+yaslrespparse(struct yaslresp * resp, const char * buf, size_t len, struct yaslrespval * val) {
+	if (!resp || !val || (!buf && len)) { return -1; }
+	if (resp->pos >= len) { return 0; }
+
+	const char * line = buf + resp->pos + 1;
+	const char * cr = memchr(line, '\r', (size_t)(buf + len - line));
+	size_t linelen, next, elements;
+	long long n;
+
+	if (!cr || cr + 1 == buf + len) { return 0; }
+	if (cr[1] != '\n') { return -1; }
+	linelen = (size_t)(cr - line);
+	next = (size_t)(cr + 2 - buf);
+
+	val->type = buf[resp->pos];
+	val->str = NULL;
+	val->len = 0;
+	val->num = 0;
+	switch (val->type) {
+	case '+': case '-': case ',': case '(':
+		val->str = line;
+		val->len = linelen;
+		break;
+	case ':':
+		if (yaslrespnum(line, linelen, &val->num)) { return -1; }
+		break;
+	case '#':
+		if (linelen != 1 || (*line != 't' && *line != 'f')) { return -1; }
+		val->num = *line == 't';
+		break;
+	case '_':
+		if (linelen) { return -1; }
+		break;
+	case '$': case '!': case '=':
+		if (yaslrespnum(line, linelen, &n)) { return -1; }
+		if (n == -1 && val->type == '$') {
+			val->type = '_';
+			break;
+		}
+		if (n < 0) { return -1; }
+		if ((unsigned long long)n > len - next || len - next - (size_t)n < 2) { return 0; }
+		if (buf[next + (size_t)n] != '\r' || buf[next + (size_t)n + 1] != '\n') { return -1; }
+		val->str = buf + next;
+		val->len = (size_t)n;
+		next += (size_t)n + 2;
+		break;
+	case '*': case '%': case '~': case '>': case '|':
+		if (yaslrespnum(line, linelen, &n)) { return -1; }
+		if (n == -1 && val->type == '*') {
+			val->type = '_';
+			break;
+		}
+		if (n < 0 || n > LLONG_MAX / 2) { return -1; }
+		val->num = n;
+		elements = (size_t)n * (val->type == '%' || val->type == '|' ? 2 : 1);
+		if (elements) {
+			if (resp->depth == YASLRESP_DEPTH) { return -1; }
+			if (val->type == '|') { resp->attrs |= UINT32_C(1) << resp->depth; }
+			resp->left[resp->depth++] = (long long)elements;
+			resp->pos = next;
+			return 1;
+		}
+		if (val->type == '|') {
+			resp->pos = next;
+			return 1;
+		}
+		break;
+	default:
+		return -1;
+	}
+	resp->pos = next;
+	yaslrespdone(resp);
+	return 1;
+}
+
+
+// Concatenation //
+
+/* Append a RESP string of type 'type' holding 'src' of length 'len' to
+ * 'dest': a simple string '+', an error '-', a double ',' or a big number
+ * '(', which cannot hold line breaks, or a bulk string '$', a bulk error '!'
+ * or a verbatim string '=', which can hold anything. A null '_' holds
+ * nothing. The whole frame is reserved at once. Returns NULL for other types,
+ * for a line break in a string that cannot hold one, and on out of memory. */
+yastr
+yaslcatresp(yastr dest, char type, const char * src, size_t len) {
+	if (!dest || (!src && len)) { return NULL; }
+
+	char head[1] = { type };
+
+	switch (type) {
+	case '+': case '-': case ',': case '(':
+		/* A peer would take the line break for the end of the frame. */
+		if (len && (memchr(src, '\r', len) || memchr(src, '\n', len))) { return NULL; }
+		dest = yaslMakeRoomFor(dest, 1 + len + 2);
+		if (!dest) { return NULL; }
+		dest = yaslcatlen(dest, head, 1);
+		break;
+	case '$': case '!': case '=':
+		dest = yaslMakeRoomFor(dest, 1 + YASLRESP_DIGITS + 2 + len + 2);
+		if (!dest) { return NULL; }
+		dest = yaslcatlen(dest, head, 1);
+		dest = yaslcatulonglong(dest, len);
+		dest = yaslcatlen(dest, "\r\n", 2);
+		break;
+	case '_':
+		return yaslcatlen(dest, "_\r\n", 3);
+	default:
+		return NULL;
+	}
+	dest = yaslcatlen(dest, src, len);
+	return yaslcatlen(dest, "\r\n", 2);
+}
+
+/* Append a RESP integer ':' or boolean '#' of value 'value' to 'dest', or the
+ * header of an aggregate of 'value' values: an array '*', a set '~' or a
+ * push '>', or of 'value' pairs: a map '%' or an attribute '|'. An array of
+ * size -1 is the null array of RESP2. Returns NULL for other types, and on
+ * out of memory. */
+yastr
+yaslcatrespint(yastr dest, char type, long long value) {
+	if (!dest) { return NULL; }
+
+	char head[1] = { type };
+
+	switch (type) {
+	case '#':
+		return yaslcatlen(dest, value ? "#t\r\n" : "#f\r\n", 4);
+	case ':': case '*': case '%': case '~': case '>': case '|':
+		break;
+	default:
+		return NULL;
+	}
+	dest = yaslMakeRoomFor(dest, 1 + YASLRESP_DIGITS + 2);
+	if (!dest) { return NULL; }
+
+	dest = yaslcatlen(dest, head, 1);
+	dest = yaslcatlonglong(dest, value);
+	return yaslcatlen(dest, "\r\n", 2);
+}
+
+/* Append the command made of the 'argc' yasl strings of 'argv' to 'dest', as
+ * an array of bulk strings. The size of the whole command is computed first,
+ * so that it is reserved at once. Returns NULL if 'argv' or one of its
+ * strings is NULL, or on out of memory. */
+yastr
+yaslcatrespcmd(yastr dest, const yastr * argv, size_t argc) {
+	if (!dest || (!argv && argc)) { return NULL; }
+
+	size_t total = 1 + yaslrespdigits((long long)argc) + 2;
+
+	for (size_t i = 0; i < argc; i++) {
+		if (!argv[i]) { return NULL; }
+		total += 1 + yaslrespdigits((long long)yasllen(argv[i])) + 2 + yasllen(argv[i]) + 2;
+	}
+	dest = yaslMakeRoomFor(dest, total);
+	if (!dest) { return NULL; }
+
+	dest = yaslcatrespint(dest, '*', (long long)argc);
+	for (size_t i = 0; i < argc; i++) {
+		dest = yaslcatresp(dest, '$', argv[i], yasllen(argv[i]));
+	}
+	return dest;
+}
@@ -0,0 +1,487 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yaslsa.h"
+
+#define YASLSA_EMPTY UINT32_MAX
+
+/* The first 8 bytes of a saved index, which also reject ones saved on a
+ * machine of the other byte order. */
+#define YASLSA_MAGIC UINT64_C(0x3130415353414c59)
+
+/* A suffix array over a text, with the longest common prefix of each
+ * suffix and the one before it in sorted order. The text is not copied. */
+struct yaslsa {
+	const unsigned char * text;
+	size_t len;
+	const uint32_t * sa;
+	const uint32_t * lcp;
+	uint32_t * mem;              /* the arrays, unless they were loaded */
+};
+
+/* A string being sorted by SA-IS, which ends with a unique smallest
+ * symbol: the text, with a virtual sentinel after its bytes, or a string of
+ * names of a recursion. */
+struct yaslsastr {
+	const unsigned char * bytes;
+	const uint32_t * syms;
+	size_t n;                    /* including the sentinel */
+};
+
+/* The part of the longest common prefix array computed by one thread. */
+struct yaslsajob {
+	const struct yaslsa * sa;
+	uint32_t * plcp;
+	uint32_t * lcp;
+	size_t begin;
+	size_t end;
+	int phase;
+};
+
+
+// Low-level helper functions //
+
+static inline uint32_t
+yaslsachr(const struct yaslsastr * s, size_t i) {
+	if (s->bytes) { return i + 1 == s->n ? 0 : (uint32_t)s->bytes[i] + 1; }
+	return s->syms[i];
+}
+
+/* Whether the suffix at 'i' is S-type, smaller than the one after it. */
+static inline int
+yaslsaistype(const uint8_t * t, size_t i) {
+	return (t[i / 8] >> (i % 8)) & 1;
+}
+
+/* Whether the suffix at 'i' is S-type and the one before it is not. */
+static inline int
+yaslsaislms(const uint8_t * t, size_t i) {
+	return i > 0 && yaslsaistype(t, i) && !yaslsaistype(t, i - 1);
+}
+
+/* Set 'bkt' to the start or the end of the bucket of each symbol. */
+static void
+yaslsabuckets(const struct yaslsastr * s, uint32_t * bkt, size_t k, int end) {
+	uint32_t sum = 0;
+
+	memset(bkt, 0, (k + 1) * sizeof(*bkt));
+	for (size_t i = 0; i < s->n; i++) { bkt[yaslsachr(s, i)]++; }
+	for (size_t i = 0; i <= k; i++) {
+		sum += bkt[i];
+		bkt[i] = end ? sum : sum - bkt[i];
+	}
+}
+
+/* Sort the L-type suffixes from the sorted S-type ones in 'sa', then the
+ * S-type suffixes from the sorted L-type ones. */
+static void
+yaslsainduce(const struct yaslsastr * s, const uint8_t * t, uint32_t * sa, uint32_t * bkt, size_t k) {
+	size_t n = s->n;
+
+	yaslsabuckets(s, bkt, k, 0);
+	for (size_t i = 0; i < n; i++) {
+		uint32_t j = sa[i];
+
+		if (j != YASLSA_EMPTY && j > 0 && !yaslsaistype(t, j - 1)) {
+			sa[bkt[yaslsachr(s, j - 1)]++] = j - 1;
+		}
+	}
+	yaslsabuckets(s, bkt, k, 1);
+	for (size_t i = n; i-- > 0;) {
+		uint32_t j = sa[i];
+
+		if (j != YASLSA_EMPTY && j > 0 && yaslsaistype(t, j - 1)) {
+			sa[--bkt[yaslsachr(s, j - 1)]] = j - 1;
+		}
+	}
+}
+
+/* Sort the suffixes of 's', whose symbols are at most 'k', into 'sa' with
+ * the SA-IS algorithm of Nong, Zhang and Chan, in linear time: the suffixes
+ * that start a run of S-type suffixes are sorted by recursion on the string
+ * of names of their substrings, and all others are induced from them. */
+static int
+yaslsasais(const struct yaslsastr * s, uint32_t * sa, size_t k) {
+	size_t n = s->n, n1 = 0, name = 0, prev = YASLSA_EMPTY;
+	uint8_t * t;
+	uint32_t * bkt, * s1;
+
+	if (n == 1) {
+		sa[0] = 0;
+		return 0;
+	}
+	t = calloc(n / 8 + 1, 1);
+	bkt = malloc((k + 1) * sizeof(*bkt));
+	if (!t || !bkt) {
+		free(t);
+		free(bkt);
+		return -1;
+	}
+
+	t[(n - 1) / 8] |= (uint8_t)(1 << ((n - 1) % 8));
+	for (size_t i = n - 2; i-- > 0;) {
+		uint32_t c = yaslsachr(s, i), d = yaslsachr(s, i + 1);
+
+		if (c < d || (c == d && yaslsaistype(t, i + 1))) { t[i / 8] |= (uint8_t)(1 << (i % 8)); }
+	}
+
+	/* Sort the substrings that start at each LMS suffix and end at the
+	 * next one, and name them by their rank. */
+	yaslsabuckets(s, bkt, k, 1);
+	for (size_t i = 0; i < n; i++) { sa[i] = YASLSA_EMPTY; }
+	for (size_t i = 1; i < n; i++) {
+		if (yaslsaislms(t, i)) { sa[--bkt[yaslsachr(s, i)]] = (uint32_t)i; }
+	}
+	yaslsainduce(s, t, sa, bkt, k);
+
+	for (size_t i = 0; i < n; i++) {
+		if (yaslsaislms(t, sa[i])) { sa[n1++] = sa[i]; }
+	}
+	for (size_t i = n1; i < n; i++) { sa[i] = YASLSA_EMPTY; }
+	for (size_t i = 0; i < n1; i++) {
+		size_t pos = sa[i];
+		int diff = 0;
+
+		for (size_t d = 0; ; d++) {
+			if (prev == YASLSA_EMPTY || yaslsachr(s, pos + d) != yaslsachr(s, prev + d) ||
+			    yaslsaistype(t, pos + d) != yaslsaistype(t, prev + d)) {
+				diff = 1;
+				break;
+			}
+			if (d > 0 && (yaslsaislms(t, pos + d) || yaslsaislms(t, prev + d))) { break; }
+		}
+		if (diff) {
+			name++;
+			prev = pos;
+		}
+		sa[n1 + pos / 2] = (uint32_t)(name - 1);
+	}
+	for (size_t i = n, j = n; i-- > n1;) {
+		if (sa[i] != YASLSA_EMPTY) { sa[--j] = sa[i]; }
+	}
+
+	/* Sort the LMS suffixes, by recursion if some of their substrings are
+	 * equal. */
+	s1 = sa + n - n1;
+	if (name < n1) {
+		struct yaslsastr r = { NULL, s1, n1 };
+
+		free(bkt);
+		bkt = NULL;
+		if (yaslsasais(&r, sa, name - 1)) {
+			free(t);
+			return -1;
+		}
+		bkt = malloc((k + 1) * sizeof(*bkt));
+		if (!bkt) {
+			free(t);
+			return -1;
+		}
+	} else {
+		for (size_t i = 0; i < n1; i++) { sa[s1[i]] = (uint32_t)i; }
+	}
+
+	/* Put the sorted LMS suffixes at the ends of their buckets, and induce
+	 * the others. */
+	for (size_t i = 1, j = 0; i < n; i++) {
+		if (yaslsaislms(t, i)) { s1[j++] = (uint32_t)i; }
+	}
+	for (size_t i = 0; i < n1; i++) { sa[i] = s1[sa[i]]; }
+	for (size_t i = n1; i < n; i++) { sa[i] = YASLSA_EMPTY; }
+	yaslsabuckets(s, bkt, k, 1);
+	for (size_t i = n1; i-- > 0;) {
+		uint32_t j = sa[i];
+
+		sa[i] = YASLSA_EMPTY;
+		sa[--bkt[yaslsachr(s, j)]] = j;
+	}
+	yaslsainduce(s, t, sa, bkt, k);
+	free(bkt);
+	free(t);
+	return 0;
+}
+
+/* Compute a part of the longest common prefixes with the algorithm of
+ * Kärkkäinen, Manzini and Puglisi, a variant of the one of Kasai et al: the
+ * prefix shared by the suffix at 'i' and the one before it in sorted order
+ * is at most one byte shorter than the one of the suffix at 'i - 1', so the
+ * suffixes are compared in text order, skipping that many bytes. */
+static void *
+yaslsalcpjob(void * arg) {
+	struct yaslsajob * job = arg;
+	const struct yaslsa * sa = job->sa;
+	const unsigned char * text = sa->text;
+	size_t h = 0;
+
+	switch (job->phase) {
+	case 0:
+		/* The suffix before each one, in sorted order. */
+		for (size_t r = job->begin; r < job->end; r++) {
+			job->plcp[sa->sa[r]] = r ? sa->sa[r - 1] : YASLSA_EMPTY;
+		}
+		break;
+	case 1:
+		for (size_t i = job->begin; i < job->end; i++) {
+			uint32_t prev = job->plcp[i];
+
+			if (prev == YASLSA_EMPTY) {
+				job->plcp[i] = 0;
+				h = 0;
+				continue;
+			}
+			while (i + h < sa->len && prev + h < sa->len && text[i + h] == text[prev + h]) { h++; }
+			job->plcp[i] = (uint32_t)h;
+			if (h) { h--; }
+		}
+		break;
+	case 2:
+		for (size_t r = job->begin; r < job->end; r++) {
+			job->lcp[r] = job->plcp[sa->sa[r]];
+		}
+		break;
+	}
+	return NULL;
+}
+
+/* Run each phase of the longest common prefix array on 'threads' threads,
+ * including the calling one, each with a part of the suffixes. If a thread
+ * cannot be started, the calling one does its part. */
+static int
+yaslsabuildlcp(struct yaslsa * sa, uint32_t * lcp, unsigned threads) {
+	uint32_t * plcp = malloc((sa->len ? sa->len : 1) * sizeof(*plcp));
+	struct yaslsajob * jobs = malloc(threads * sizeof(*jobs));
+	pthread_t * tids = threads > 1 ? malloc((threads - 1) * sizeof(*tids)) : NULL;
+
+	if (!plcp || !jobs || (threads > 1 && !tids)) {
+		free(plcp);
+		free(jobs);
+		free(tids);
+		return -1;
+	}
+	for (int phase = 0; phase < 3; phase++) {
+		unsigned started = 0;
+
+		for (unsigned j = 0; j < threads; j++) {
+			jobs[j] = (struct yaslsajob){ sa, plcp, lcp, sa->len * j / threads, sa->len * (j + 1) / threads, phase };
+		}
+		for (unsigned j = 1; j < threads; j++) {
+			if (pthread_create(&tids[j - 1], NULL, yaslsalcpjob, &jobs[j])) { break; }
+			started++;
+		}
+		for (unsigned j = started + 1; j < threads; j++) { yaslsalcpjob(&jobs[j]); }
+		yaslsalcpjob(&jobs[0]);
+		for (unsigned j = 0; j < started; j++) { pthread_join(tids[j], NULL); }
+	}
+	free(tids);
+	free(jobs);
+	free(plcp);
+	return 0;
+}
+
+/* Compare the first 'len' bytes of the suffix at 'pos' with 'pattern', of
+ * which the first '*lcp' are known to be equal, and store the length of the
+ * common prefix in '*lcp'. Returns 0 if the suffix starts with the pattern,
+ * and a negative or positive value if it is smaller or larger. */
+static int
+yaslsacmp(const struct yaslsa * sa, size_t pos, const char * pattern, size_t len, size_t * lcp) {
+	size_t k = *lcp, avail = sa->len - pos;
+
+	while (k < len && k < avail && sa->text[pos + k] == (unsigned char)pattern[k]) { k++; }
+	*lcp = k;
+	if (k == len) { return 0; }
+	if (k == avail) { return -1; }
+	return sa->text[pos + k] < (unsigned char)pattern[k] ? -1 : 1;
+}
+
+
+// Initialization //
+
+/* Build a suffix array over 'text' of length 'len', which can be a yasl
+ * string or a mapped file, and must stay valid and unchanged as long as the
+ * index is used. Returns NULL on out of memory, or if the text is 4 GiB or
+ * longer. */
+struct yaslsa *
+yaslsanew(const char * text, size_t len) {
+	return yaslsanewparallel(text, len, 1);
+}
+
+/* Like yaslsanew(), but uses up to 'threads' threads for the longest common
+ * prefix array. The suffix array itself is built with SA-IS, which uses a
+ * single thread. */
+struct yaslsa *
+yaslsanewparallel(const char * text, size_t len, unsigned threads) {
+	if ((!text && len) || len > UINT32_MAX - 2) { return NULL; }
+
+	struct yaslsa * sa = malloc(sizeof(*sa));
+	struct yaslsastr s = { (const unsigned char *)text, NULL, len + 1 };
+	if (!sa) { return NULL; }
+
+	if (threads < 1) { threads = 1; }
+	if (threads > len / 65536 + 1) { threads = (unsigned)(len / 65536 + 1); }
+	sa->text = (const unsigned char *)text;
+	sa->len = len;
+	sa->mem = malloc((2 * len + 1) * sizeof(uint32_t));
+	if (!sa->mem || yaslsasais(&s, sa->mem, 256)) {
+		free(sa->mem);
+		free(sa);
+		return NULL;
+	}
+	/* The sentinel is the smallest suffix. */
+	sa->sa = sa->mem + 1;
+	sa->lcp = sa->mem + len + 1;
+	if (yaslsabuildlcp(sa, sa->mem + len + 1, threads)) {
+		free(sa->mem);
+		free(sa);
+		return NULL;
+	}
+	return sa;
+}
+
+/* Load an index of 'text' of length 'len' saved with yaslcatsa(), from 'src'
+ * of length 'srclen', which must be aligned to 4 bytes, like a mapped file.
+ * The arrays are not copied, so loading takes constant time, and 'src' must
+ * stay valid as long as the index is used. Returns NULL if 'src' is not an
+ * index of a text of this length, or on out of memory. The contents of the
+ * arrays are not checked, so 'src' must come from a trusted source. */
+struct yaslsa *
+yaslsaload(const char * text, size_t len, const void * src, size_t srclen) {
+	if ((!text && len) || !src || (uintptr_t)src % sizeof(uint32_t)) { return NULL; }
+
+	uint64_t head[2];
+	struct yaslsa * sa;
+
+	if (srclen < sizeof(head)) { return NULL; }
+	memcpy(head, src, sizeof(head));
+	if (head[0] != YASLSA_MAGIC || head[1] != len || (srclen - sizeof(head)) / 8 < len) { return NULL; }
+
+	sa = malloc(sizeof(*sa));
+	if (!sa) { return NULL; }
+
+	sa->text = (const unsigned char *)text;
+	sa->len = len;
+	sa->sa = (const uint32_t *)(const void *)((const char *)src + sizeof(head));
+	sa->lcp = sa->sa + len;
+	sa->mem = NULL;
+	return sa;
+}
+
+
+// Querying //
+
+/* Find the suffixes that start with 'pattern' of length 'len', which are
+ * consecutive in sorted order, with two binary searches. Stores the rank of
+ * the first one in '*first', unless it is NULL, and returns their number,
+ * which is the number of occurrences of the pattern in the text. The part of
+ * the pattern known to be shared by the suffixes at both ends of the range
+ * is not compared again. */
+size_t
+yaslsasearch(const struct yaslsa * sa, const char * pattern, size_t len, size_t * first) {
+	if (!sa || (!pattern && len)) { return 0; }
+
+	size_t lo = 0, hi = sa->len, llcp = 0, rlcp = 0, start;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2, k = llcp < rlcp ? llcp : rlcp;
+
+		if (yaslsacmp(sa, sa->sa[mid], pattern, len, &k) < 0) {
+			lo = mid + 1;
+			llcp = k;
+		} else {
+			hi = mid;
+			rlcp = k;
+		}
+	}
+	start = lo;
+	hi = sa->len;
+	rlcp = 0;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2, k = llcp < rlcp ? llcp : rlcp;
+
+		if (yaslsacmp(sa, sa->sa[mid], pattern, len, &k) <= 0) {
+			lo = mid + 1;
+			llcp = k;
+		} else {
+			hi = mid;
+			rlcp = k;
+		}
+	}
+	if (first) { *first = start; }
+	return lo - start;
+}
+
+/* Return the number of occurrences of 'pattern' of length 'len' in the
+ * text, which may overlap. */
+size_t
+yaslsacount(const struct yaslsa * sa, const char * pattern, size_t len) {
+	return yaslsasearch(sa, pattern, len, NULL);
+}
+
+/* Store the offsets of up to 'max' occurrences of 'pattern' of length 'len'
+ * in 'offsets', in the order of the suffixes that start there, and return
+ * the number of occurrences. */
+size_t
+yaslsalocate(const struct yaslsa * sa, const char * pattern, size_t len, size_t * offsets, size_t max) {
+	size_t first, count = yaslsasearch(sa, pattern, len, &first);
+
+	if (!offsets) { return count; }
+	for (size_t i = 0; i < count && i < max; i++) { offsets[i] = sa->sa[first + i]; }
+	return count;
+}
+
+/* Return the offset of the suffix of rank 'rank' in sorted order, which must
+ * be smaller than the length of the text. */
+size_t
+yaslsaoffset(const struct yaslsa * sa, size_t rank) {
+	return sa->sa[rank];
+}
+
+/* Return the length of the longest common prefix of the suffix of rank
+ * 'rank' and the one before it, or 0 for the first one. */
+size_t
+yaslsalcp(const struct yaslsa * sa, size_t rank) {
+	return sa->lcp[rank];
+}
+
+
+// Concatenation //
+
+/* Append the index to 'dest', to be loaded with yaslsaload(). It takes 8
+ * bytes per byte of the text, and can only be loaded on a machine of the
+ * same byte order. Returns NULL if 'sa' is NULL, or on out of memory. */
+yastr
+yaslcatsa(yastr dest, const struct yaslsa * sa) {
+	if (!dest || !sa) { return NULL; }
+
+	uint64_t head[2] = { YASLSA_MAGIC, sa->len };
+
+	dest = yaslMakeRoomFor(dest, sizeof(head) + 2 * sa->len * sizeof(uint32_t));
+	if (!dest) { return NULL; }
+
+	dest = yaslcatlen(dest, head, sizeof(head));
+	dest = yaslcatlen(dest, sa->sa, sa->len * sizeof(uint32_t));
+	return yaslcatlen(dest, sa->lcp, sa->len * sizeof(uint32_t));
+}
+
+
+// Freeing //
+
+/* Free an index, but not its text. No operation is performed if 'sa' is
+ * NULL. */
+void
+yaslsafree(struct yaslsa * sa) {
+	if (!sa) { return; }
+
+	free(sa->mem);
+	free(sa);
+}
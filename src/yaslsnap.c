@@ -0,0 +1,211 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "yaslmap.h"
+#include "yaslsnap.h"
+
+#define YASLSNAP_MAGIC UINT64_C(0x31504e534c534159)  /* "YASLSNP1" */
+#define YASLSNAP_HEAD (4 * sizeof(uint64_t))
+
+/* A snapshot is a header of four 64 bit words: the magic number, the number
+ * of strings, the size of the snapshot and a checksum of the rest. It is
+ * followed by the offsets of the strings from the start of the snapshot, as
+ * 64 bit words, and then by the strings themselves, each with the header of a
+ * static yasl string in front and a null byte after, so that they can be used
+ * in place as yasl strings that are never freed or modified. */
+struct yaslsnap {
+	const char * base;
+	size_t count;
+	const uint64_t * offsets;
+	void * map;                  /* the mapping of yaslsnapopen(), if any */
+	size_t maplen;
+};
+
+
+// Low-level helper functions //
+
+/* Check that the strings of the snapshot at 'base' of 'size' bytes, listed in
+ * 'offsets', are in bounds, in order, and look like the ones written by
+ * yaslcatsnap(). Returns 0 if they do, and -1 otherwise. */
+static int
+yaslsnapcheck(const char * base, size_t size, const uint64_t * offsets, size_t count) {
+	size_t pos = YASLSNAP_HEAD + count * sizeof(uint64_t);
+
+	for (size_t i = 0; i < count; i++) {
+		struct yastrhdr hdr;
+		uint64_t off = offsets[i];
+
+		if (off < pos + sizeof(hdr) || off >= size) { return -1; }
+		memcpy(&hdr, base + off - sizeof(hdr), sizeof(hdr));
+		if (hdr.len > size - 1 - off || hdr.free || hdr.flags != YASL_STATIC) { return -1; }
+		if (base[off + hdr.len]) { return -1; }
+		pos = (size_t)off + hdr.len + 1;
+	}
+	return 0;
+}
+
+
+// Initialization //
+
+/* Load a snapshot written by yaslcatsnap() from 'src' of length 'len', which
+ * must be aligned to 8 bytes, like a mapped file. Its strings are used in
+ * place, so 'src' must stay valid as long as the snapshot is used. The whole
+ * snapshot is read once to check its checksum and its layout, so that a
+ * damaged one is never used. Returns NULL if 'src' is not a valid snapshot,
+ * or on out of memory. */
+struct yaslsnap *
+yaslsnapload(const void * src, size_t len) {
+	if (!src || (uintptr_t)src % sizeof(uint64_t) || len < YASLSNAP_HEAD) { return NULL; }
+
+	const char * base = src;
+	const uint64_t * offsets = (const uint64_t *)(const void *)(base + YASLSNAP_HEAD);
+	uint64_t head[4];
+	struct yaslsnap * snap;
+
+	memcpy(head, src, sizeof(head));
+	if (head[0] != YASLSNAP_MAGIC || head[2] < YASLSNAP_HEAD || head[2] > len) { return NULL; }
+	len = (size_t)head[2];
+	if (head[1] > (len - YASLSNAP_HEAD) / (sizeof(uint64_t) + sizeof(struct yastrhdr) + 1)) { return NULL; }
+	if (yaslhash(base + YASLSNAP_HEAD, len - YASLSNAP_HEAD, 0) != head[3]) { return NULL; }
+	if (yaslsnapcheck(base, len, offsets, (size_t)head[1])) { return NULL; }
+
+	snap = malloc(sizeof(*snap));
+	if (!snap) { return NULL; }
+
+	snap->base = base;
+	snap->count = (size_t)head[1];
+	snap->offsets = offsets;
+	snap->map = NULL;
+	snap->maplen = 0;
+	return snap;
+}
+
+/* Map the file at 'path' read-only and load the snapshot it holds with
+ * yaslsnapload(). The pages of the file are shared with other processes that
+ * map it, but opening it takes time in the size of the file, since the
+ * checksum and the layout pass of yaslsnapload() read every page of it.
+ * Returns NULL if the file cannot be mapped or is not a valid snapshot. */
+struct yaslsnap *
+yaslsnapopen(const char * path) {
+	if (!path) { return NULL; }
+
+	int fd = open(path, O_RDONLY);
+	struct yaslsnap * snap;
+	struct stat st;
+	void * map;
+
+	if (fd < 0) { return NULL; }
+	if (fstat(fd, &st) || st.st_size <= 0 || (uintmax_t)st.st_size > SIZE_MAX) {
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) { return NULL; }
+
+	snap = yaslsnapload(map, (size_t)st.st_size);
+	if (!snap) {
+		munmap(map, (size_t)st.st_size);
+		return NULL;
+	}
+	snap->map = map;
+	snap->maplen = (size_t)st.st_size;
+	return snap;
+}
+
+
+// Querying //
+
+/* Return the number of strings in the snapshot. */
+size_t
+yaslsnapcount(const struct yaslsnap * snap) {
+	if (!snap) { return 0; }
+
+	return snap->count;
+}
+
+/* Return the string at 'index' in the snapshot, or NULL if it is out of
+ * range. It is a static yasl string inside the snapshot, so nothing is
+ * copied: yaslfree() ignores it, and functions that modify a string return
+ * a modified copy of it, as does yasldup(). */
+yastr
+yaslsnapget(const struct yaslsnap * snap, size_t index) {
+	if (!snap || index >= snap->count) { return NULL; }
+
+	return (yastr)(snap->base + snap->offsets[index]);
+}
+
+
+// Concatenation //
+
+/* Append a snapshot of the 'count' yasl strings of 'strs', such as the
+ * result of yaslsplitlen(), to 'dest', to be loaded with yaslsnapload(). It
+ * can only be loaded on a machine of the same byte order, at an offset
+ * aligned to 8 bytes. Returns NULL if 'strs' or one of its strings is NULL,
+ * or on out of memory. */
+yastr
+yaslcatsnap(yastr dest, const yastr * strs, size_t count) {
+	if (!dest || (!strs && count)) { return NULL; }
+
+	const size_t hdrlen = sizeof(struct yastrhdr);
+	uint64_t head[4] = { YASLSNAP_MAGIC, count, 0, 0 };
+	size_t total = YASLSNAP_HEAD, pos;
+	char * base;
+
+	if (count > (SIZE_MAX - total) / (sizeof(uint64_t) + hdrlen + 1)) { return NULL; }
+	total += count * (sizeof(uint64_t) + hdrlen + 1);
+	for (size_t i = 0; i < count; i++) {
+		if (!strs[i]) { return NULL; }
+		if (yasllen(strs[i]) > SIZE_MAX - total) { return NULL; }
+		total += yasllen(strs[i]);
+	}
+
+	dest = yaslMakeRoomFor(dest, total);
+	if (!dest) { return NULL; }
+
+	base = dest + yasllen(dest);
+	pos = YASLSNAP_HEAD + count * sizeof(uint64_t);
+	for (size_t i = 0; i < count; i++) {
+		struct yastrhdr hdr = { yasllen(strs[i]), 0, YASL_STATIC };
+		uint64_t off = pos + hdrlen;
+
+		memcpy(base + YASLSNAP_HEAD + i * sizeof(uint64_t), &off, sizeof(off));
+		memcpy(base + pos, &hdr, hdrlen);
+		memcpy(base + off, strs[i], hdr.len);
+		base[off + hdr.len] = '\0';
+		pos = (size_t)off + hdr.len + 1;
+	}
+	head[2] = total;
+	head[3] = yaslhash(base + YASLSNAP_HEAD, total - YASLSNAP_HEAD, 0);
+	memcpy(base, head, sizeof(head));
+	yaslIncrLen(dest, total);
+	return dest;
+}
+
+
+// Freeing //
+
+/* Free a snapshot, and unmap it if it was opened with yaslsnapopen(). The
+ * strings it holds cannot be used anymore, unless they were copied. No
+ * operation is performed if 'snap' is NULL. */
+void
+yaslsnapfree(struct yaslsnap * snap) {
+	if (!snap) { return; }
+
+	if (snap->map) { munmap(snap->map, snap->maplen); }
+	free(snap);
+}
@@ -0,0 +1,413 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yaslsort.h"
+
+/* Groups smaller than this are insertion sorted, and groups smaller than
+ * YASLSORT_RADIX are split with multikey quicksort instead of a radix pass. */
+#define YASLSORT_INSERTION 16
+#define YASLSORT_RADIX 256
+
+/* Number of strings loaded or stored at a time by a single thread. */
+#define YASLSORT_CHUNK 65536
+
+/* The strings are sorted through an array of these, so that most comparisons
+ * only touch the cached key instead of chasing the string pointer. */
+struct yaslsortentry {
+	uint64_t key;                /* bytes 'depth' to 'depth + 8', big-endian */
+	size_t len;
+	yastr str;
+};
+
+struct yaslsorttask {
+	size_t off;
+	size_t n;
+	size_t depth;
+	unsigned b;
+};
+
+struct yaslsortjob {
+	yastr * argv;
+	struct yaslsortentry * entries;
+	size_t count;
+	int store;                   /* whether chunks are loaded or stored */
+	struct yaslsorttask * tasks;
+	size_t ntasks;
+	size_t slots;
+	size_t next;                 /* the next chunk or task to hand out */
+	pthread_mutex_t lock;
+};
+
+
+// Low-level helper functions //
+
+/* Load the up to 8 bytes of 'str' starting at 'depth' as a big-endian key,
+ * padded with zero bytes. */
+static uint64_t
+yaslsortload(const char * str, size_t len, size_t depth) {
+	uint64_t key = 0;
+	size_t n;
+
+	if (len <= depth) { return 0; }
+	n = len - depth < 8 ? len - depth : 8;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	if (n == 8) {
+		memcpy(&key, str + depth, 8);
+		return __builtin_bswap64(key);
+	}
+#endif
+	for (size_t j = 0; j < n; j++) {
+		key |= (uint64_t)(unsigned char)str[depth + j] << (56 - 8 * j);
+	}
+	return key;
+}
+
+/* The symbol at byte 'b' of the key: 0 if the string has ended, otherwise the
+ * byte plus one, so that shorter strings sort first. */
+static inline unsigned
+yaslsortsym(const struct yaslsortentry * e, size_t depth, unsigned b) {
+	if (e->len <= depth + b) { return 0; }
+	return (unsigned)(e->key >> (56 - 8 * b) & 0xff) + 1;
+}
+
+/* Move the keys of a group forward to the next 8 bytes. */
+static void
+yaslsortreload(struct yaslsortentry * e, size_t n, size_t depth) {
+	for (size_t j = 0; j < n; j++) {
+		e[j].key = yaslsortload(e[j].str, e[j].len, depth);
+	}
+}
+
+/* Compare two entries which are known to be equal up to 'depth'. */
+static int
+yaslsortcmp(const struct yaslsortentry * a, const struct yaslsortentry * b, size_t depth) {
+	size_t p = depth + 8;
+	int cmp;
+
+	if (a->key != b->key) { return a->key < b->key ? -1 : 1; }
+	/* With equal keys, a string that ends within the key is a prefix of the
+	 * other one, whose remaining key bytes are all zero. */
+	if (a->len > p && b->len > p) {
+		cmp = memcmp(a->str + p, b->str + p, (a->len < b->len ? a->len : b->len) - p);
+		if (cmp) { return cmp; }
+	}
+	if (a->len == b->len) { return 0; }
+	return a->len < b->len ? -1 : 1;
+}
+
+static void
+yaslsortinsertion(struct yaslsortentry * e, size_t n, size_t depth) {
+	for (size_t j = 1; j < n; j++) {
+		struct yaslsortentry tmp = e[j];
+		size_t k = j;
+
+		for (; k > 0 && yaslsortcmp(&tmp, &e[k - 1], depth) < 0; k--) {
+			e[k] = e[k - 1];
+		}
+		e[k] = tmp;
+	}
+}
+
+/* Permute a group in place into the 257 buckets of byte 'b' of the keys
+ * (American flag sort), storing the bucket sizes in 'count'. */
+static void
+yaslsortradix(struct yaslsortentry * e, size_t n, size_t depth, unsigned b, size_t * count) {
+	size_t next[257], end[257], pos = 0;
+
+	memset(count, 0, 257 * sizeof(size_t));
+	for (size_t j = 0; j < n; j++) {
+		count[yaslsortsym(&e[j], depth, b)]++;
+	}
+	for (unsigned k = 0; k < 257; k++) {
+		next[k] = pos;
+		pos += count[k];
+		end[k] = pos;
+	}
+	for (unsigned k = 0; k < 257; k++) {
+		while (next[k] < end[k]) {
+			struct yaslsortentry tmp = e[next[k]], swap;
+			unsigned s = yaslsortsym(&tmp, depth, b);
+
+			while (s != k) {
+				swap = e[next[s]];
+				e[next[s]++] = tmp;
+				tmp = swap;
+				s = yaslsortsym(&tmp, depth, b);
+			}
+			e[next[k]++] = tmp;
+		}
+	}
+}
+
+/* Sort a group whose strings are equal up to byte 'b' of the keys. Smaller
+ * parts are recursed into and the largest one is looped on, which bounds the
+ * stack depth regardless of how long the common prefixes are. */
+static void
+yaslsortrec(struct yaslsortentry * e, size_t n, size_t depth, unsigned b) {
+	while (n > 1) {
+		if (b == 8) {
+			depth += 8;
+			b = 0;
+			yaslsortreload(e, n, depth);
+		}
+		if (n < YASLSORT_INSERTION) {
+			yaslsortinsertion(e, n, depth);
+			return;
+		}
+
+		if (n < YASLSORT_RADIX) {
+			/* Multikey quicksort: three-way partition on the symbol. */
+			unsigned s0 = yaslsortsym(&e[0], depth, b);
+			unsigned s1 = yaslsortsym(&e[n / 2], depth, b);
+			unsigned s2 = yaslsortsym(&e[n - 1], depth, b);
+			unsigned pivot = s0 < s1 ? (s1 < s2 ? s1 : (s0 < s2 ? s2 : s0))
+			                         : (s0 < s2 ? s0 : (s1 < s2 ? s2 : s1));
+			size_t lt = 0, gt = n, j = 0;
+			struct yaslsortentry tmp;
+
+			while (j < gt) {
+				unsigned s = yaslsortsym(&e[j], depth, b);
+				if (s < pivot) {
+					tmp = e[lt]; e[lt++] = e[j]; e[j++] = tmp;
+				} else if (s > pivot) {
+					tmp = e[--gt]; e[gt] = e[j]; e[j] = tmp;
+				} else {
+					j++;
+				}
+			}
+
+			size_t eq = pivot ? gt - lt : 0;
+			if (lt >= n - gt && lt >= eq) {
+				yaslsortrec(e + gt, n - gt, depth, b);
+				if (eq) { yaslsortrec(e + lt, eq, depth, b + 1); }
+				n = lt;
+			} else if (n - gt >= eq) {
+				yaslsortrec(e, lt, depth, b);
+				if (eq) { yaslsortrec(e + lt, eq, depth, b + 1); }
+				e += gt;
+				n -= gt;
+			} else {
+				yaslsortrec(e, lt, depth, b);
+				yaslsortrec(e + gt, n - gt, depth, b);
+				e += lt;
+				n = eq;
+				b++;
+			}
+			continue;
+		}
+
+		size_t count[257], pos, largest = 1, largestpos = 0;
+
+		yaslsortradix(e, n, depth, b, count);
+		/* Bucket 0 holds the strings that ended, which are all equal. */
+		pos = count[0];
+		for (unsigned k = 2; k < 257; k++) {
+			if (count[k] > count[largest]) { largest = k; }
+		}
+		for (unsigned k = 1; k < 257; k++) {
+			if (k == largest) {
+				largestpos = pos;
+			} else if (count[k] > 1) {
+				yaslsortrec(e + pos, count[k], depth, b + 1);
+			}
+			pos += count[k];
+		}
+		e += largestpos;
+		n = count[largest];
+		b++;
+	}
+}
+
+static void
+yaslsortpush(struct yaslsortjob * job, struct yaslsortentry * e, size_t n, size_t depth, unsigned b) {
+	if (job->ntasks == job->slots) {
+		size_t slots = job->slots ? job->slots * 2 : 256;
+		struct yaslsorttask * tasks = realloc(job->tasks, slots * sizeof(*tasks));
+
+		if (!tasks) {
+			/* No room to queue it, so sort it right away instead. */
+			yaslsortrec(e, n, depth, b);
+			return;
+		}
+		job->tasks = tasks;
+		job->slots = slots;
+	}
+	job->tasks[job->ntasks++] = (struct yaslsorttask){
+		(size_t)(e - job->entries), n, depth, b
+	};
+}
+
+/* Split a group with radix passes until every part is at most 'grain' in
+ * size, and queue the parts to be sorted in parallel. */
+static void
+yaslsortsplit(struct yaslsortjob * job, struct yaslsortentry * e, size_t n, size_t depth, unsigned b, size_t grain) {
+	while (n > grain) {
+		size_t count[257], pos, largest = 1, largestpos = 0;
+
+		if (b == 8) {
+			depth += 8;
+			b = 0;
+			yaslsortreload(e, n, depth);
+		}
+		yaslsortradix(e, n, depth, b, count);
+		pos = count[0];
+		for (unsigned k = 2; k < 257; k++) {
+			if (count[k] > count[largest]) { largest = k; }
+		}
+		for (unsigned k = 1; k < 257; k++) {
+			if (k == largest) {
+				largestpos = pos;
+			} else if (count[k] > 1) {
+				yaslsortsplit(job, e + pos, count[k], depth, b + 1, grain);
+			}
+			pos += count[k];
+		}
+		e += largestpos;
+		n = count[largest];
+		b++;
+	}
+	if (n > 1) { yaslsortpush(job, e, n, depth, b); }
+}
+
+/* Load the strings into the entries, or store them back, a chunk at a time. */
+static void *
+yaslsortchunks(void * arg) {
+	struct yaslsortjob * job = arg;
+
+	while (1) {
+		pthread_mutex_lock(&job->lock);
+		size_t start = job->next;
+		job->next += YASLSORT_CHUNK;
+		pthread_mutex_unlock(&job->lock);
+		if (start >= job->count) { break; }
+
+		size_t end = job->count - start < YASLSORT_CHUNK ? job->count : start + YASLSORT_CHUNK;
+		for (size_t j = start; j < end; j++) {
+			if (job->store) {
+				job->argv[j] = job->entries[j].str;
+			} else {
+				job->entries[j].str = job->argv[j];
+				job->entries[j].len = yasllen(job->argv[j]);
+				job->entries[j].key = yaslsortload(job->argv[j], job->entries[j].len, 0);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void *
+yaslsorttasks(void * arg) {
+	struct yaslsortjob * job = arg;
+
+	while (1) {
+		pthread_mutex_lock(&job->lock);
+		size_t j = job->next++;
+		pthread_mutex_unlock(&job->lock);
+		if (j >= job->ntasks) { break; }
+
+		struct yaslsorttask * t = &job->tasks[j];
+		yaslsortrec(job->entries + t->off, t->n, t->depth, t->b);
+	}
+	return NULL;
+}
+
+/* Run 'fn' on 'threads' threads, including the calling one. If a thread
+ * cannot be started the remaining ones just do more of the work. */
+static void
+yaslsortrun(struct yaslsortjob * job, void * (*fn)(void *), unsigned threads) {
+	pthread_t * tids = threads > 1 ? malloc((threads - 1) * sizeof(pthread_t)) : NULL;
+	unsigned started = 0;
+
+	job->next = 0;
+	if (tids) {
+		for (; started < threads - 1; started++) {
+			if (pthread_create(&tids[started], NULL, fn, job)) { break; }
+		}
+	}
+	fn(job);
+	for (unsigned j = 0; j < started; j++) {
+		pthread_join(tids[j], NULL);
+	}
+	free(tids);
+}
+
+
+// Modification //
+
+/* Sort an array of yasl strings in the order of yaslcmp(). The strings are
+ * sorted with an MSD radix sort over a cached array of 8-byte key prefixes,
+ * falling back to multikey quicksort and insertion sort for small groups.
+ * Returns 0 on success, or -1 on out of memory, in which case the array is
+ * left untouched. */
+int
+yaslsort(yastr * argv, size_t count) {
+	return yaslsortparallel(argv, count, 1);
+}
+
+/* Like yaslsort(), but uses up to 'threads' threads. The array is first split
+ * into independent groups by radix passes, which are then sorted in
+ * parallel. */
+int
+yaslsortparallel(yastr * argv, size_t count, unsigned threads) {
+	if (!argv) { return -1; }
+
+	struct yaslsortjob job = { .argv = argv, .count = count };
+	size_t grain;
+
+	if (count < 2) { return 0; }
+	if (threads < 1) { threads = 1; }
+	if (threads > count / YASLSORT_CHUNK + 1) {
+		threads = (unsigned)(count / YASLSORT_CHUNK + 1);
+	}
+
+	job.entries = malloc(count * sizeof(struct yaslsortentry));
+	if (!job.entries) { return -1; }
+	pthread_mutex_init(&job.lock, NULL);
+
+	yaslsortrun(&job, yaslsortchunks, threads);
+	if (threads == 1) {
+		yaslsortrec(job.entries, count, 0, 0);
+	} else {
+		grain = count / (threads * 8);
+		if (grain < YASLSORT_CHUNK) { grain = YASLSORT_CHUNK; }
+		yaslsortsplit(&job, job.entries, count, 0, 0, grain);
+		yaslsortrun(&job, yaslsorttasks, threads);
+	}
+	job.store = 1;
+	yaslsortrun(&job, yaslsortchunks, threads);
+
+	pthread_mutex_destroy(&job.lock);
+	free(job.tasks);
+	free(job.entries);
+	return 0;
+}
+
+/* Remove adjacent duplicates from an array of yasl strings, such as a sorted
+ * one, freeing them. Returns the new number of strings in the array. */
+size_t
+yasluniq(yastr * argv, size_t count) {
+	if (!argv || !count) { return 0; }
+
+	size_t last = 0;
+
+	for (size_t j = 1; j < count; j++) {
+		if (yasllen(argv[j]) == yasllen(argv[last]) &&
+		    !memcmp(argv[j], argv[last], yasllen(argv[j]))) {
+			yaslfree(argv[j]);
+		} else {
+			argv[++last] = argv[j];
+		}
+	}
+	return last + 1;
+}
@@ -0,0 +1,261 @@
+/* yasl, Yet Another String Library for C
+ *
+ * Copyright (c) 2014-2015, The yasl developers
+ *
+ * This file is under the 2-clause BSD license. See the LICENSE file for the
+ * full license text
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yasltpl.h"
+
+enum yasltplkind {
+	YASLTPL_LITERAL,
+	YASLTPL_STR,                 /* %s */
+	YASLTPL_YASL,                /* %S */
+	YASLTPL_CHAR,                /* %c */
+	YASLTPL_INT,                 /* %d and %i */
+	YASLTPL_LONG,                /* %ld and %li */
+	YASLTPL_LLONG,               /* %lld and %lli */
+	YASLTPL_UINT,                /* %u */
+	YASLTPL_ULONG,               /* %lu */
+	YASLTPL_ULLONG,              /* %llu */
+	YASLTPL_SIZE                 /* %zu */
+};
+
+/* A literal run, which is a slice of the literals of the template, or a slot
+ * for an argument of the given kind. */
+struct yasltplop {
+	enum yasltplkind kind;
+	size_t off;
+	size_t len;
+};
+
+struct yasltpl {
+	yastr literals;              /* all literal runs, with %% unescaped */
+	size_t count;
+	struct yasltplop ops[];
+};
+
+
+// Low-level helper functions //
+
+static size_t
+yasltpldigits(unsigned long long value) {
+	size_t n = 1;
+
+	while (value >= 10000) {
+		value /= 10000;
+		n += 4;
+	}
+	return n + (value >= 10) + (value >= 100) + (value >= 1000);
+}
+
+static size_t
+yasltplsigned(long long value) {
+	if (value >= 0) { return yasltpldigits((unsigned long long)value); }
+	return 1 + yasltpldigits(0ULL - (unsigned long long)value);
+}
+
+
+// Initialization //
+
+/* Parse the printf style format string 'fmt' into a template. The supported
+ * conversions are %s, %c, %d, %i and %u, the last three optionally with the l
+ * or ll length modifier, %zu, %% and %S for a yasl string, without flags,
+ * field widths or precisions. Returns NULL on any other conversion or on out
+ * of memory. */
+struct yasltpl *
+yasltplnew(const char * fmt) {
+	if (!fmt) { return NULL; }
+
+	struct yasltpl * tpl;
+	struct yasltplop * op = NULL;
+	size_t slots = 1;
+
+	for (const char * p = fmt; *p; p++) {
+		if (*p == '%') { slots += 2; }
+	}
+	tpl = malloc(sizeof(*tpl) + slots * sizeof(struct yasltplop));
+	if (!tpl) { return NULL; }
+	tpl->count = 0;
+	tpl->literals = yaslempty();
+	if (!tpl->literals) { goto fail; }
+
+	while (*fmt) {
+		enum yasltplkind kind;
+		const char * run;
+		size_t len;
+		yastr tmp;
+
+		if (fmt[0] != '%' || fmt[1] == '%') {
+			/* A literal run up to the next conversion, where %% is one %.
+			 * Consecutive runs are merged into a single op. */
+			if (fmt[0] == '%') {
+				run = fmt + 1;
+				len = 1;
+				fmt += 2;
+			} else {
+				run = fmt;
+				fmt = strchr(fmt, '%');
+				if (!fmt) { fmt = run + strlen(run); }
+				len = (size_t)(fmt - run);
+			}
+			if (!op || op->kind != YASLTPL_LITERAL) {
+				op = &tpl->ops[tpl->count++];
+				op->kind = YASLTPL_LITERAL;
+				op->off = yasllen(tpl->literals);
+				op->len = 0;
+			}
+			tmp = yaslcatlen(tpl->literals, run, len);
+			if (!tmp) { goto fail; }
+			tpl->literals = tmp;
+			op->len += len;
+			continue;
+		}
+
+		fmt++;
+		if (fmt[0] == 's') {
+			kind = YASLTPL_STR;
+		} else if (fmt[0] == 'S') {
+			kind = YASLTPL_YASL;
+		} else if (fmt[0] == 'c') {
+			kind = YASLTPL_CHAR;
+		} else if (fmt[0] == 'd' || fmt[0] == 'i') {
+			kind = YASLTPL_INT;
+		} else if (fmt[0] == 'u') {
+			kind = YASLTPL_UINT;
+		} else if (fmt[0] == 'l' && (fmt[1] == 'd' || fmt[1] == 'i')) {
+			kind = YASLTPL_LONG;
+			fmt++;
+		} else if (fmt[0] == 'l' && fmt[1] == 'u') {
+			kind = YASLTPL_ULONG;
+			fmt++;
+		} else if (fmt[0] == 'l' && fmt[1] == 'l' && (fmt[2] == 'd' || fmt[2] == 'i')) {
+			kind = YASLTPL_LLONG;
+			fmt += 2;
+		} else if (fmt[0] == 'l' && fmt[1] == 'l' && fmt[2] == 'u') {
+			kind = YASLTPL_ULLONG;
+			fmt += 2;
+		} else if (fmt[0] == 'z' && fmt[1] == 'u') {
+			kind = YASLTPL_SIZE;
+			fmt++;
+		} else {
+			goto fail;
+		}
+		fmt++;
+		op = &tpl->ops[tpl->count++];
+		op->kind = kind;
+		op->off = op->len = 0;
+	}
+	return tpl;
+
+fail:
+	yasltplfree(tpl);
+	return NULL;
+}
+
+
+// Concatenation //
+
+/* Append the template 'tpl' rendered with the arguments in 'ap' to 'dest'.
+ * The length of the result is measured first, so 'dest' grows at most once,
+ * and the arguments are then appended straight into it. */
+yastr
+yaslcatvtpl(yastr dest, const struct yasltpl * tpl, va_list ap) {
+	if (!dest || !tpl) { return NULL; }
+
+	const struct yasltplop * op, * end = tpl->ops + tpl->count;
+	size_t total = 0;
+	const char * s;
+	va_list cpy;
+	yastr tmp;
+
+	va_copy(cpy, ap);
+	for (op = tpl->ops; op < end; op++) {
+		switch (op->kind) {
+		case YASLTPL_LITERAL: total += op->len; break;
+		case YASLTPL_STR:
+			s = va_arg(cpy, const char *);
+			total += s ? strlen(s) : 6;
+			break;
+		case YASLTPL_YASL:   total += yasllen(va_arg(cpy, yastr)); break;
+		case YASLTPL_CHAR:   (void)va_arg(cpy, int); total++; break;
+		case YASLTPL_INT:    total += yasltplsigned(va_arg(cpy, int)); break;
+		case YASLTPL_LONG:   total += yasltplsigned(va_arg(cpy, long)); break;
+		case YASLTPL_LLONG:  total += yasltplsigned(va_arg(cpy, long long)); break;
+		case YASLTPL_UINT:   total += yasltpldigits(va_arg(cpy, unsigned)); break;
+		case YASLTPL_ULONG:  total += yasltpldigits(va_arg(cpy, unsigned long)); break;
+		case YASLTPL_ULLONG: total += yasltpldigits(va_arg(cpy, unsigned long long)); break;
+		case YASLTPL_SIZE:   total += yasltpldigits(va_arg(cpy, size_t)); break;
+		}
+	}
+	va_end(cpy);
+
+	tmp = yaslMakeRoomFor(dest, total);
+	if (!tmp) { return NULL; }
+	dest = tmp;
+
+	/* Nothing below can grow the string anymore. */
+	for (op = tpl->ops; op < end; op++) {
+		yastr y;
+		char c;
+
+		switch (op->kind) {
+		case YASLTPL_LITERAL:
+			dest = yaslcatlen(dest, tpl->literals + op->off, op->len);
+			break;
+		case YASLTPL_STR:
+			s = va_arg(ap, const char *);
+			dest = yaslcat(dest, s ? s : "(null)");
+			break;
+		case YASLTPL_YASL:
+			y = va_arg(ap, yastr);
+			if (y) { dest = yaslcatyasl(dest, y); }
+			break;
+		case YASLTPL_CHAR:
+			c = (char)va_arg(ap, int);
+			dest = yaslcatlen(dest, &c, 1);
+			break;
+		case YASLTPL_INT:    dest = yaslcatlonglong(dest, va_arg(ap, int)); break;
+		case YASLTPL_LONG:   dest = yaslcatlonglong(dest, va_arg(ap, long)); break;
+		case YASLTPL_LLONG:  dest = yaslcatlonglong(dest, va_arg(ap, long long)); break;
+		case YASLTPL_UINT:   dest = yaslcatulonglong(dest, va_arg(ap, unsigned)); break;
+		case YASLTPL_ULONG:  dest = yaslcatulonglong(dest, va_arg(ap, unsigned long)); break;
+		case YASLTPL_ULLONG: dest = yaslcatulonglong(dest, va_arg(ap, unsigned long long)); break;
+		case YASLTPL_SIZE:   dest = yaslcatulonglong(dest, va_arg(ap, size_t)); break;
+		}
+	}
+	return dest;
+}
+
+/* Like yaslcatvtpl(), but takes the arguments directly, like
+ * yaslcatprintf(). */
+yastr
+yaslcattpl(yastr dest, const struct yasltpl * tpl, ...) {
+	if (!dest || !tpl) { return NULL; }
+
+	va_list ap;
+	yastr t;
+
+	va_start(ap, tpl);
+	t = yaslcatvtpl(dest, tpl, ap);
+	va_end(ap);
+	return t;
+}
+
+
+// Freeing //
+
+/* Free a template. No operation is performed if 'tpl' is NULL. */
+void
+yasltplfree(struct yasltpl * tpl) {
+	if (!tpl) { return; }
+
+	yaslfree(tpl->literals);
+	free(tpl);
+}
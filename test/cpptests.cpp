@@ -0,0 +1,71 @@
+/* Tests for the C++ wrapper in yasl.hpp, which is checked separately from
+ * the C test suite since it needs a C++17 compiler. */
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+#include <yasl.hpp>
+
+static int failed = 0;
+
+#define check(cond) do { \
+	if (!(cond)) { \
+		std::printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+		failed = 1; \
+	} \
+} while (0)
+
+int
+main() {
+	using namespace std::literals;
+
+	yasl::string a("hello"sv);
+	check(a.size() == 5 && a.view() == "hello");
+
+	a.reserve(100);
+	yastr before = a.get();
+	a.append(", "sv).append(std::string_view("world")) += '!';
+	check(a.get() == before && a.capacity() >= 100);
+	check(std::string_view(a) == "hello, world!" && a.c_str()[a.size()] == '\0');
+
+	yasl::string b = std::move(a);
+	check(!a.get() && a.empty() && a.view().empty());
+	a += "again"sv;
+	check(a.view() == "again");
+
+	yasl::string c = b.dup();
+	check(c == b && c.get() != b.get());
+
+	yastr raw = c.release();
+	check(!c.get() && raw);
+	yasl::string d = yasl::string::adopt(raw);
+	check(d.get() == raw && d != a && a < d);
+
+	std::unordered_set<yasl::string> set;
+	set.insert(std::move(d));
+	set.insert(yasl::string("again"sv));
+	check(set.size() == 2 && set.count(a) == 1);
+
+	yasl::string prefix("user:"sv);
+	yastr raw2 = yaslnew("id\0x", 4);
+	raw2 = yaslcatlen(raw2, "y", 1);
+	std::string tail("/end");
+	yasl::string key = prefix + yasl::ref(raw2) + ':' + -42 + "|" + 18446744073709551615ULL
+		+ std::string_view("|") + 0 + tail;
+	check(key.view() == "user:id\0xy:-42|18446744073709551615|0/end"sv);
+	check(key.capacity() == key.size());
+	key += key + ':' + prefix;
+	check(key.view() == "user:id\0xy:-42|18446744073709551615|0/enduser:id\0xy:-42|18446744073709551615|0/end:user:"sv);
+	key = yasl::ref(raw2) + 'z';
+	check(key.view() == "id\0xyz"sv);
+	yaslfree(raw2);
+
+	a.clear();
+	check(a.empty() && a.capacity() > 0);
+
+	std::printf(failed ? "Failed\n" : "Passed\n");
+	return failed;
+}
@@ -1,5 +1,23 @@
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <yasl.h>
+#include <yaslcsv.h>
+#include <yaslsort.h>
+#include <yasllz.h>
+#include <yasltpl.h>
+#include <yaslac.h>
+#include <yaslglob.h>
+#include <yaslmap.h>
+#include <yaslrax.h>
+#include <yasldist.h>
+#include <yaslsa.h>
+#include <yaslbuf.h>
+#include <yaslsnap.h>
+#include <yaslfc.h>
+#include <yaslresp.h>
 #include "twbctf.h"
 
 static inline void yaslfrees(yastr *string) { if (*string) yaslfree(*string); }
@@ -198,6 +216,908 @@ declare_test(yasltoupper_ascii_digits) {
 	return (!memcmp(x, "0FOO1BAR\n\0", 10) == 0);
 }
 
+declare_test(yaslfind_first_and_last) {
+	_yastr_cleanup_ yastr x = yaslauto("abcabcabcabcabcabcabcabcabcabcXYZabc");
+	return !(yaslfind(x, "abc", 3) == 0 && yaslrfind(x, "abc", 3) == 33 &&
+	         yaslfind(x, "XYZ", 3) == 30 && yaslrfind(x, "XYZ", 3) == 30 &&
+	         yaslfind(x, "abd", 3) == -1 && yaslrfind(x, "c", 1) == 35);
+}
+
+declare_test(yaslcount_non_overlapping) {
+	_yastr_cleanup_ yastr x = yaslauto("aaaaa");
+	return !(yaslcount(x, "aa", 2) == 2 && yaslcount(x, "b", 1) == 0);
+}
+
+declare_test(yaslreplace_shorter) {
+	_yastr_cleanup_ yastr x = yaslauto("a--b--c--");
+	x = yaslreplace(x, "--", 2, "+", 1);
+	return !(yasllen(x) == 6 && memcmp(x, "a+b+c+\0", 7) == 0);
+}
+
+declare_test(yaslreplace_longer) {
+	_yastr_cleanup_ yastr x = yaslauto("{x} and {x}, not {y}");
+	x = yaslreplace(x, "{x}", 3, "value", 5);
+	return !(yasllen(x) == 24 && memcmp(x, "value and value, not {y}\0", 25) == 0);
+}
+
+declare_test(yaslreplace_overlapping_pattern) {
+	_yastr_cleanup_ yastr x = yaslauto("aaa");
+	x = yaslreplace(x, "aa", 2, "bbb", 3);
+	return !(yasllen(x) == 4 && memcmp(x, "bbba\0", 5) == 0);
+}
+
+declare_test(yaslutf8valid_sequences) {
+	_yastr_cleanup_ yastr good = yaslauto("plain ascii text, then h\xc3\xa9llo w\xc3\xb6rld \xe2\x82\xac \xf0\x9f\x98\x80");
+	_yastr_cleanup_ yastr overlong = yaslauto("\xc0\xaf");
+	_yastr_cleanup_ yastr surrogate = yaslauto("\xed\xa0\x80");
+	_yastr_cleanup_ yastr truncated = yaslauto("abc\xe2\x82");
+	return !(yaslutf8valid(good) && !yaslutf8valid(overlong) &&
+	         !yaslutf8valid(surrogate) && !yaslutf8valid(truncated));
+}
+
+declare_test(yaslutf8len_counts_code_points) {
+	_yastr_cleanup_ yastr x = yaslauto("h\xc3\xa9llo w\xc3\xb6rld \xe2\x82\xac \xf0\x9f\x98\x80 and some more ascii");
+	return !(yaslutf8len(x) == 35);
+}
+
+declare_test(yaslutf8range_code_points) {
+	_yastr_cleanup_ yastr x = yaslauto("a\xc3\xa9\xe2\x82\xac" "b");
+	yaslutf8range(x, 1, -2);
+	return !(yasllen(x) == 5 && memcmp(x, "\xc3\xa9\xe2\x82\xac\0", 6) == 0);
+}
+
+declare_test(yaslutf8trunc_keeps_sequences) {
+	_yastr_cleanup_ yastr x = yaslauto("ab\xe2\x82\xac");
+	yaslutf8trunc(x, 4);
+	return !(yasllen(x) == 2 && memcmp(x, "ab\0", 3) == 0);
+}
+
+declare_test(yaslcatutf8_validates) {
+	_yastr_cleanup_ yastr x = yaslauto("ok:");
+	x = yaslcatutf8(x, "\xc3\xa9t\xc3\xa9", 5);
+	if (!x || yasllen(x) != 8) { return 1; }
+	return !(yaslcatutf8(x, "bad\xff", 4) == NULL && yasllen(x) == 8 &&
+	         memcmp(x, "ok:\xc3\xa9t\xc3\xa9\0", 9) == 0);
+}
+
+declare_test(yaslcathex_roundtrip) {
+	_yastr_cleanup_ yastr x = yaslcathex(yaslempty(), "\x00\x01\xab\xff yasl strings are binary safe", 34);
+	_yastr_cleanup_ yastr y = yaslcatunhex(yaslauto(">"), x, yasllen(x));
+	return !(yasllen(x) == 68 && memcmp(x, "0001abff", 8) == 0 && yasllen(y) == 35 &&
+	         memcmp(y, ">\x00\x01\xab\xff yasl strings are binary safe", 35) == 0);
+}
+
+declare_test(yaslcatunhex_rejects_invalid) {
+	_yastr_cleanup_ yastr x = yaslauto("foo");
+	return !(yaslcatunhex(x, "0g", 2) == NULL && yaslcatunhex(x, "abc", 3) == NULL &&
+	         yasllen(x) == 3 && memcmp(x, "foo\0", 4) == 0);
+}
+
+declare_test(yaslcatbase64_roundtrip) {
+	_yastr_cleanup_ yastr x = yaslcatbase64(yaslempty(), "\xfb\xff", 2);
+	_yastr_cleanup_ yastr y = yaslcatbase64url(yaslempty(), "\xfb\xff", 2);
+	_yastr_cleanup_ yastr z = yaslcatunbase64(yaslempty(), x, yasllen(x));
+	_yastr_cleanup_ yastr w = yaslcatunbase64url(yaslempty(), y, yasllen(y));
+	return !(memcmp(x, "+/8=\0", 5) == 0 && memcmp(y, "-_8\0", 4) == 0 &&
+	         yasllen(z) == 2 && memcmp(z, "\xfb\xff", 2) == 0 &&
+	         yasllen(w) == 2 && memcmp(w, "\xfb\xff", 2) == 0 &&
+	         yaslcatunbase64(z, "-_8=", 4) == NULL);
+}
+
+declare_test(yaslcatpercent_roundtrip) {
+	_yastr_cleanup_ yastr x = yaslcatpercent(yaslempty(), "a b/c~d.e_f-g&h=\xff", 17);
+	_yastr_cleanup_ yastr y = yaslcatunpercent(yaslempty(), x, yasllen(x));
+	return !(strcmp(x, "a%20b%2Fc~d.e_f-g%26h%3D%FF") == 0 && yasllen(y) == 17 &&
+	         memcmp(y, "a b/c~d.e_f-g&h=\xff", 17) == 0 &&
+	         yaslcatunpercent(y, "%4", 2) == NULL);
+}
+
+declare_test(yaslcatjson_escapes) {
+	_yastr_cleanup_ yastr x = yaslcatjson(yaslempty(), "say \"hi\"\\\n\x01\xc3\xa9", 13, 0);
+	_yastr_cleanup_ yastr y = yaslcatjson(yaslempty(), "\xc3\xa9\xf0\x9f\x98\x80", 6, 1);
+	return !(strcmp(x, "\"say \\\"hi\\\"\\\\\\n\\u0001\xc3\xa9\"") == 0 &&
+	         strcmp(y, "\"\\u00e9\\ud83d\\ude00\"") == 0);
+}
+
+declare_test(yaslcatunjson_roundtrip) {
+	_yastr_cleanup_ yastr x = yaslauto("\"a\\tb\\\"\\u00e9\\ud83d\\ude00\\/\"");
+	_yastr_cleanup_ yastr y = yaslcatunjson(yaslempty(), x, yasllen(x));
+	_yastr_cleanup_ yastr z = yaslauto("\"raw \"quote\"");
+	return !(y && yasllen(y) == 11 && memcmp(y, "a\tb\"\xc3\xa9\xf0\x9f\x98\x80/", 11) == 0 &&
+	         yaslcatunjson(y, z, yasllen(z)) == NULL && yasllen(y) == 11);
+}
+
+static int
+csv_collect(const struct yaslcsvfield * fields, size_t count, void * ctx) {
+	yastr * out = ctx;
+	for (size_t i = 0; i < count; i++) {
+		*out = yaslcatlen(*out, fields[i].data, fields[i].len);
+		*out = yaslcat(*out, i + 1 < count ? "|" : "\n");
+	}
+	return 0;
+}
+
+declare_test(yaslcsv_quoted_fields) {
+	const char * in = "a,\"b,c\",\"say \"\"hi\"\"\"\r\n\"multi\nline\",,x\n\nlast,\"\"";
+	_yastr_cleanup_ yastr out = yaslempty();
+	struct yaslcsv * csv = yaslcsvnew(',', '"');
+	int ret = yaslcsvfeed(csv, in, strlen(in), csv_collect, &out) ||
+	          yaslcsvfinish(csv, csv_collect, &out);
+	yaslcsvfree(csv);
+	return !(ret == 0 && strcmp(out, "a|b,c|say \"hi\"\nmulti\nline||x\nlast|\n") == 0);
+}
+
+declare_test(yaslcsv_chunk_boundaries) {
+	const char * in = "id,name\n1,\"Smith, \"\"J\"\"\"\n2,\"two\r\nlines\"\n3,plain\n";
+	const char * expect = "id|name\n1|Smith, \"J\"\n2|two\r\nlines\n3|plain\n";
+	size_t len = strlen(in);
+	for (size_t step = 1; step <= len; step++) {
+		_yastr_cleanup_ yastr out = yaslempty();
+		struct yaslcsv * csv = yaslcsvnew(',', '"');
+		int ret = 0;
+		for (size_t i = 0; i < len && !ret; i += step) {
+			ret = yaslcsvfeed(csv, in + i, i + step > len ? len - i : step, csv_collect, &out);
+		}
+		ret = ret || yaslcsvfinish(csv, csv_collect, &out);
+		yaslcsvfree(csv);
+		if (ret || strcmp(out, expect) != 0) { return 1; }
+	}
+	return 0;
+}
+
+declare_test(yaslcsv_rejects_malformed) {
+	_yastr_cleanup_ yastr out = yaslempty();
+	struct yaslcsv * csv = yaslcsvnew(',', '"');
+	int bad_close = yaslcsvfeed(csv, "\"a\"b,c\n", 7, csv_collect, &out);
+	yaslcsvfree(csv);
+	csv = yaslcsvnew(',', '"');
+	int fed = yaslcsvfeed(csv, "\"open,", 6, csv_collect, &out);
+	int unterminated = yaslcsvfinish(csv, csv_collect, &out);
+	yaslcsvfree(csv);
+	return !(bad_close == -1 && fed == 0 && unterminated == -1 && yasllen(out) == 0);
+}
+
+declare_test(yaslsplitlenvec_packs_tokens) {
+	struct yaslvec vec;
+	yaslvecinit(&vec);
+	int ret = yaslsplitlenvec(&vec, "a,,bc,", 6, ",", 1);
+	bool ok = ret == 0 && vec.count == 4 && yasllen(vec.data) == 7
+		&& yaslveclen(&vec, 0) == 1 && !strcmp(yaslvecget(&vec, 0), "a")
+		&& yaslveclen(&vec, 1) == 0 && !strcmp(yaslvecget(&vec, 2), "bc")
+		&& yaslveclen(&vec, 3) == 0;
+	yaslvecfree(&vec);
+	return !ok;
+}
+
+declare_test(yaslsplitargsvec_quotes_and_errors) {
+	struct yaslvec vec;
+	yaslvecinit(&vec);
+	int ret = yaslsplitargsvec(&vec, "set \"a\\x41 b\" 'c d'");
+	int bad = yaslsplitargsvec(&vec, "more \"unbalanced");
+	bool ok = ret == 0 && bad == -1 && vec.count == 3
+		&& !strcmp(yaslvecget(&vec, 0), "set")
+		&& yaslveclen(&vec, 1) == 4 && !strcmp(yaslvecget(&vec, 1), "aA b")
+		&& !strcmp(yaslvecget(&vec, 2), "c d") && yasllen(vec.data) == 13;
+	yaslvecfree(&vec);
+	return !ok;
+}
+
+declare_test(yaslsplitargsvec_short_tokens) {
+	const char * lines[] = { "a", "a b c", "x yz", "abc de f ghijk" };
+	const char * joined[] = { "a", "a|b|c", "x|yz", "abc|de|f|ghijk" };
+	bool ok = true;
+	for (size_t i = 0; ok && i < 4; i++) {
+		struct yaslvec vec;
+		yaslvecinit(&vec);
+		ok = !yaslsplitargsvec(&vec, lines[i]) && !yaslsplitargsvec(&vec, lines[i]);
+		_yastr_cleanup_ yastr all = yasljoinvec(&vec, "|", 1);
+		_yastr_cleanup_ yastr twice = yaslcatprintf(yaslempty(), "%s|%s", joined[i], joined[i]);
+		ok = ok && all && twice && !yaslcmp(all, twice);
+		yaslvecfree(&vec);
+	}
+	return !ok;
+}
+
+declare_test(yaslvec_join_and_convert) {
+	struct yaslvec vec;
+	size_t count;
+	yaslvecinit(&vec);
+	yastr * tokens = yaslsplitlen("x--yy--", 7, "--", 2, &count);
+	yaslvecfromarray(&vec, tokens, count);
+	yaslfreesplitres(tokens, count);
+	yaslvecappend(&vec, "z", 1);
+	_yastr_cleanup_ yastr joined = yasljoinvec(&vec, ", ", 2);
+	tokens = yaslvectoarray(&vec);
+	bool ok = vec.count == 4 && yasllen(joined) == 10
+		&& !memcmp(joined, "x, yy, , z", 10) && yasllen(tokens[1]) == 2
+		&& !strcmp(tokens[3], "z");
+	yaslfreesplitres(tokens, vec.count);
+	yaslvecclear(&vec);
+	ok = ok && vec.count == 0 && yasllen(vec.data) == 0;
+	yaslvecfree(&vec);
+	return !ok;
+}
+
+declare_test(yaslsort_matches_yaslcmp) {
+	const char * words[] = { "b", "ab", "a\0", "", "abcdefghij", "abcdefghi", "a", "ab", "b" };
+	size_t lens[] = { 1, 2, 2, 0, 10, 9, 1, 2, 1 };
+	yastr * tokens = malloc(9 * sizeof(yastr));
+	for (size_t j = 0; j < 9; j++) {
+		tokens[j] = yaslnew(words[j], lens[j]);
+	}
+	int ret = yaslsort(tokens, 9);
+	bool ok = ret == 0;
+	for (size_t j = 1; j < 9; j++) {
+		ok = ok && yaslcmp(tokens[j - 1], tokens[j]) <= 0;
+	}
+	size_t count = yasluniq(tokens, 9);
+	ok = ok && count == 7 && yasllen(tokens[0]) == 0 && yasllen(tokens[2]) == 2
+		&& !memcmp(tokens[2], "a\0", 2) && !strcmp(tokens[6], "b");
+	yaslfreesplitres(tokens, count);
+	return !ok;
+}
+
+declare_test(yaslsortparallel_large) {
+	size_t count = 200000;
+	yastr * tokens = malloc(count * sizeof(yastr));
+	unsigned seed = 1;
+	for (size_t j = 0; j < count; j++) {
+		seed = seed * 1103515245 + 12345;
+		tokens[j] = yaslfromlonglong((long long)(seed % 50000));
+	}
+	int ret = yaslsortparallel(tokens, count, 4);
+	bool ok = ret == 0;
+	for (size_t j = 1; j < count; j++) {
+		ok = ok && yaslcmp(tokens[j - 1], tokens[j]) <= 0;
+	}
+	count = yasluniq(tokens, count);
+	for (size_t j = 1; j < count; j++) {
+		ok = ok && yaslcmp(tokens[j - 1], tokens[j]) < 0;
+	}
+	yaslfreesplitres(tokens, count);
+	return !ok;
+}
+
+YASL_LITERAL(static_sep, ", ");
+
+declare_test(yasl_literal_is_a_yastr) {
+	YASL_LITERAL(prefix, "key:");
+	_yastr_cleanup_ yastr x = yaslcatyasl(yaslauto("a"), static_sep);
+	yastr tokens[] = { prefix, static_sep };
+	_yastr_cleanup_ yastr joined = yasljoinyasl(tokens, 2, "|", 1);
+	return !(yasllen(prefix) == 4 && yaslavail(prefix) == 0 && !strcmp(prefix, "key:")
+		&& yasllen(x) == 3 && !memcmp(x, "a, ", 4) && yaslcmp(prefix, joined) < 0
+		&& yasllen(joined) == 7 && !memcmp(joined, "key:|, ", 8));
+}
+
+declare_test(yasl_literal_is_immutable) {
+	YASL_LITERAL(lit, "Hello World");
+	yastr copy = yaslcat(lit, "!");
+	yastr lower = yaslmapchars(lit, "o", "0", 1);
+	yaslfree(lit);
+	bool ok = yasllen(lit) == 11 && !strcmp(lit, "Hello World")
+		&& copy != lit && !strcmp(copy, "Hello World!")
+		&& lower != lit && !strcmp(lower, "Hell0 W0rld");
+	yaslfree(copy);
+	yaslfree(lower);
+	return !ok;
+}
+
+declare_test(yaslcat_copies_literals) {
+	YASL_LITERAL(lit, "ab");
+	yastr out[] = {
+		yaslcatutf8(lit, "", 0), yaslcatutf8(lit, "\xc3\xa9", 2),
+		yaslcathex(lit, "", 0), yaslcatunhex(lit, "", 0), yaslcatunhex(lit, "63", 2),
+		yaslcatbase64(lit, "", 0), yaslcatbase64url(lit, "c", 1),
+		yaslcatunbase64(lit, "", 0), yaslcatunbase64url(lit, "Yw", 2),
+		yaslcatpercent(lit, "", 0), yaslcatunpercent(lit, "", 0),
+		yaslcatunpercent(lit, "%63", 3), yaslcatjson(lit, "", 0, 0),
+		yaslcatunjson(lit, "\"\"", 2), yaslcatunjson(lit, "\"c\"", 3),
+		yaslcatlonglong(lit, 0), yaslcatulonglong(lit, 0),
+	};
+	const char * expected[] = {
+		"ab", "ab\xc3\xa9", "ab", "ab", "abc", "ab", "abYw", "ab", "abc",
+		"ab", "ab", "abc", "ab\"\"", "ab", "abc", "ab0", "ab0",
+	};
+	bool ok = !strcmp(lit, "ab") && yasllen(lit) == 2;
+	for (size_t i = 0; i < sizeof(out) / sizeof(out[0]); i++) {
+		ok = ok && out[i] && out[i] != lit && !strcmp(out[i], expected[i]);
+		yaslfree(out[i]);
+	}
+	return !ok;
+}
+
+declare_test(inline_fast_paths_and_fallbacks) {
+	YASL_LITERAL(lit, "ab");
+	_yastr_cleanup_ yastr x = yaslMakeRoomFor(yaslempty(), 8);
+	yastr before = x;
+	x = yaslcatlen(x, "ab", 2);
+	x = yaslcat(x, "cd");
+	x = yaslcatyasl(x, lit);
+	bool ok = x == before && yasllen(x) == 6 && yaslavail(x) >= 2
+		&& !strcmp(x, "abcdab");
+	x = yaslcpylen(x, "xyz", 3);
+	x = yaslcat(x, "0123456789abcdef");
+	_yastr_cleanup_ yastr y = yaslcatlen(lit, "c", 1);
+	return !(ok && yasllen(x) == 19 && !strcmp(x, "xyz0123456789abcdef")
+		&& y != lit && !strcmp(y, "abc") && !strcmp(lit, "ab"));
+}
+
+declare_test(yaslcatlz_roundtrip) {
+	_yastr_cleanup_ yastr text = yaslempty();
+	for (int j = 0; j < 200; j++) {
+		text = yaslcatprintf(text, "key:%d=value, ", j % 10);
+	}
+	_yastr_cleanup_ yastr packed = yaslcatlz(yaslauto("lz:"), text, yasllen(text));
+	_yastr_cleanup_ yastr unpacked = yaslcatunlz(yaslauto(">"), packed + 3, yasllen(packed) - 3);
+	_yastr_cleanup_ yastr empty = yaslcatunlz(yaslempty(), "\0\0", 2);
+	return !(yasllen(packed) * 3 < yasllen(text)
+		&& yasllzlen(packed + 3, yasllen(packed) - 3) == (ptrdiff_t)yasllen(text)
+		&& yasllen(unpacked) == yasllen(text) + 1 && !memcmp(unpacked + 1, text, yasllen(text))
+		&& empty && yasllen(empty) == 0);
+}
+
+declare_test(yaslcatunlz_rejects_malformed) {
+	_yastr_cleanup_ yastr x = yaslauto("keep");
+	/* A match reaching before the start, a truncated block, a block shorter
+	 * than its recorded length, and one missing its last token. */
+	bool ok = !yaslcatunlz(x, "\x08\x10" "a\x02\x00\x00", 6)
+		&& !yaslcatunlz(x, "\x05\x50" "ab", 4)
+		&& !yaslcatunlz(x, "\x09\x10" "a\x01\x00\x00", 6)
+		&& !yaslcatunlz(x, "\x05\x10" "a\x01\x00", 5)
+		&& !yaslcatunlz(x, "", 0);
+	x = yaslcatunlz(x, "\x05\x10" "a\x01\x00\x00", 6);
+	/* Decoding straight into the free space still leaves it terminated. */
+	_yastr_cleanup_ yastr room = yaslMakeRoomFor(yaslauto("ab"), 16);
+	YASL_LITERAL(lit, "lit");
+	_yastr_cleanup_ yastr copy = yaslcatunlz(lit, "\0\0", 2);
+	ok = ok && room && !yaslcatunlz(room, "\x05\x10" "a\x01\x00", 5) && strlen(room) == 2
+		&& copy && copy != lit && !strcmp(copy, "lit");
+	return !(ok && x && yasllen(x) == 9 && !memcmp(x, "keepaaaaa", 10));
+}
+
+declare_test(yasllz_streaming_roundtrip) {
+	struct yasllz * lz = yasllznew(), * unlz = yasllznew();
+	_yastr_cleanup_ yastr packed = yaslempty();
+	_yastr_cleanup_ yastr text = yaslempty();
+	_yastr_cleanup_ yastr out = yaslempty();
+	for (int j = 0; j < 4000; j++) {
+		text = yaslcatprintf(text, "line %d of the log\n", j % 300);
+	}
+	for (size_t j = 0; j < yasllen(text); j += 1000) {
+		size_t n = yasllen(text) - j < 1000 ? yasllen(text) - j : 1000;
+		packed = yasllzcompress(lz, packed, text + j, n);
+	}
+	packed = yasllzfinish(lz, packed);
+	for (size_t j = 0; j < yasllen(packed); j += 7) {
+		size_t n = yasllen(packed) - j < 7 ? yasllen(packed) - j : 7;
+		out = yasllzdecompress(unlz, out, packed + j, n);
+	}
+	bool ok = yasllzdone(unlz) && yasllen(packed) * 5 < yasllen(text)
+		&& yasllen(out) == yasllen(text) && !memcmp(out, text, yasllen(text))
+		&& !yasllzdecompress(unlz, out, "x", 1);
+	yasllzfree(lz);
+	yasllzfree(unlz);
+	return !ok;
+}
+
+declare_test(yaslcatlonglong_limits) {
+	_yastr_cleanup_ yastr x = yaslfromlonglong(LLONG_MIN);
+	_yastr_cleanup_ yastr y = yaslauto("n=");
+	y = yaslcatlonglong(y, LLONG_MAX);
+	y = yaslcatulonglong(y, ULLONG_MAX);
+	y = yaslcatlonglong(y, 0);
+	return !(!strcmp(x, "-9223372036854775808")
+		&& !strcmp(y, "n=9223372036854775807184467440737095516150"));
+}
+
+declare_test(yaslcattpl_renders_like_printf) {
+	struct yasltpl * tpl = yasltplnew("%%%s=%d%%, %S %c%lu %lld/%zu%u%%");
+	_yastr_cleanup_ yastr name = yaslauto("yasl");
+	_yastr_cleanup_ yastr x = yaslauto(">");
+	_yastr_cleanup_ yastr y = yaslauto(">");
+	for (int j = -3; j < 3; j++) {
+		x = yaslcattpl(x, tpl, "k", j * 1000, name, 'c', 42UL, LLONG_MIN,
+		               (size_t)j, 7U);
+		y = yaslcatprintf(y, "%%%s=%d%%, %s %c%lu %lld/%zu%u%%", "k", j * 1000,
+		                  name, 'c', 42UL, LLONG_MIN, (size_t)j, 7U);
+	}
+	bool ok = x && yasllen(x) == yasllen(y) && !strcmp(x, y);
+	yasltplfree(tpl);
+	return !ok;
+}
+
+declare_test(yasltplnew_rejects_unsupported) {
+	struct yasltpl * tpl = yasltplnew("plain");
+	_yastr_cleanup_ yastr x = yaslcattpl(yaslempty(), tpl);
+	bool ok = x && !strcmp(x, "plain") && !yasltplnew("%5d")
+		&& !yasltplnew("%f") && !yasltplnew("trailing %");
+	yasltplfree(tpl);
+	return !ok;
+}
+
+declare_test(yaslconsume_from_the_front) {
+	yastr x = yaslauto("GET / HTTP/1.1\r\n");
+	x = yaslcatlen(x, "PING\r\n", 6);
+	x = yaslconsume(x, 16);
+	bool ok = yasllen(x) == 6 && !strcmp(x, "PING\r\n");
+	for (int j = 0; j < 10000; j++) {
+		x = yaslcatprintf(x, "%d\n", j);
+		x = yaslconsume(x, yaslfind(x, "\n", 1) + 1);
+	}
+	ok = ok && !strcmp(x, "9999\n") && yaslAllocSize(x) < 4 * YASL_MIN_COMPACT;
+	x = yaslconsume(x, 100);
+	ok = ok && yasllen(x) == 0 && !yaslconsume(NULL, 1);
+	x = yaslRemoveFreeSpace(yaslcat(x, "left"));
+	ok = ok && !strcmp(x, "left") && yaslAllocSize(x) == sizeof(struct yastrhdr) + 5;
+	yaslfree(x);
+	return !ok;
+}
+
+declare_test(yaslconsume_static_string) {
+	YASL_LITERAL(lit, "prefix-rest");
+	_yastr_cleanup_ yastr x = yaslconsume(lit, 7);
+	return !(x && x != lit && !strcmp(x, "rest") && !strcmp(lit, "prefix-rest")
+		&& yaslconsume(lit, 0) == lit);
+}
+
+static int
+collect_matches(size_t id, size_t offset, void * ctx) {
+	yastr * out = ctx;
+	*out = yaslcatprintf(*out, "%zu@%zu ", id, offset);
+	return 0;
+}
+
+declare_test(yaslac_finds_all_matches) {
+	yastr patterns[] = { yaslauto("he"), yaslauto("she"), yaslauto("his"),
+	                     yaslauto("hers"), yaslauto("he") };
+	struct yaslac * ac = yaslacnew(patterns, 5);
+	_yastr_cleanup_ yastr all = yaslempty();
+	_yastr_cleanup_ yastr chunked = yaslempty();
+	struct yaslacstream stream;
+	const char * text = "ushers his";
+	size_t id = 0;
+	int rv = yaslacscan(ac, text, strlen(text), collect_matches, &all);
+	yaslacstreaminit(&stream);
+	for (size_t j = 0; j < strlen(text); j++) {
+		rv |= yaslacfeed(ac, &stream, text + j, 1, collect_matches, &chunked);
+	}
+	bool ok = !rv && !strcmp(all, "1@1 0@2 4@2 3@2 2@7 ")
+		&& !strcmp(chunked, all) && yaslacfind(ac, text, strlen(text), &id) == 1
+		&& id == 1 && yaslacfind(ac, "nothing", 7, &id) == -1;
+	yaslacfree(ac);
+	for (size_t j = 0; j < 5; j++) { yaslfree(patterns[j]); }
+	return !ok;
+}
+
+declare_test(yaslacnew_rejects_empty) {
+	yastr patterns[] = { yaslauto("a"), yaslempty() };
+	struct yaslac * ac = yaslacnew(patterns, 2);
+	bool ok = !ac && !yaslacnew(patterns, 0);
+	yaslfree(patterns[0]);
+	yaslfree(patterns[1]);
+	return !ok;
+}
+
+declare_test(yaslglobmatch_patterns) {
+	struct yaslglob * g = yaslglobnew("user:*:[a-c]?\\*:*log", 20, 0);
+	struct yaslglob * ci = yaslglobnew("*SESSION*[^0-9]", 15, YASLGLOB_NOCASE);
+	_yastr_cleanup_ yastr key = yaslauto("user:42:bx*:access.log");
+	bool ok = yaslglobmatch(g, key) && !yaslglobmatchlen(g, key, 21)
+		&& !yaslglobmatchlen(g, "user:42:dx*:access.log", 22)
+		&& yaslglobmatchlen(ci, "web:Session:a", 13)
+		&& !yaslglobmatchlen(ci, "web:session:1", 13)
+		&& !yaslglobnew("[abc", 4, 0) && !yaslglobnew("ab\\", 3, 0);
+	yaslglobfree(g);
+	yaslglobfree(ci);
+	return !ok;
+}
+
+declare_test(yaslmap_put_get_del) {
+	struct yaslmap * map = yaslmapnew(sizeof(int));
+	_yastr_cleanup_ yastr key = yaslempty();
+	bool ok = map && yaslmapcount(map) == 0;
+	for (int j = 0; j < 5000; j++) {
+		yaslclear(key);
+		key = yaslcatprintf(key, "key:%d", j);
+		int * v = yaslmapput(map, key, yasllen(key));
+		ok = ok && v && *v == 0;
+		*v = j;
+	}
+	for (int j = 0; j < 5000; j += 2) {
+		yaslclear(key);
+		key = yaslcatprintf(key, "key:%d", j);
+		ok = ok && !yaslmapdel(map, key, yasllen(key));
+	}
+	int * v = yaslmapget(map, "key:4999", 8);
+	ok = ok && v && *v == 4999 && !yaslmapget(map, "key:4998", 8)
+		&& !yaslmapget(map, "key:4999\0", 9) && yaslmapdel(map, "key:0", 5) == -1
+		&& yaslmapcount(map) == 2500;
+	size_t iter = 0, n = 0;
+	yastr k;
+	while (!yaslmapnext(map, &iter, &k, (void **)&v)) {
+		n++;
+		ok = ok && *v % 2 == 1 && atoi(k + 4) == *v;
+	}
+	yaslmapfree(map);
+	return !(ok && n == 2500);
+}
+
+declare_test(yaslhash_spreads_bits) {
+	uint64_t a = yaslhash("key:1", 5, 0), b = yaslhash("key:2", 5, 0);
+	uint64_t c = yaslhash("key:1", 5, 1), d = yaslhash("", 0, 0);
+	return !(a != b && a != c && (a ^ b) >> 32 && (uint32_t)(a ^ b)
+		&& d == yaslhash(NULL, 0, 0) && a == yaslhash("key:1", 5, 0));
+}
+
+declare_test(yaslrax_put_get_del) {
+	struct yaslrax * rax = yaslraxnew();
+	_yastr_cleanup_ yastr key = yaslempty();
+	bool ok = rax && yaslraxcount(rax) == 0;
+	for (int j = 0; j < 3000; j++) {
+		yaslclear(key);
+		key = yaslcatprintf(key, "%c:%d", j % 200 + 1, j);
+		void ** v = yaslraxput(rax, key, yasllen(key));
+		ok = ok && v && !*v;
+		*v = (void *)(intptr_t)(j + 1);
+	}
+	void ** v = yaslraxput(rax, "", 0);
+	ok = ok && v && !*v && yaslraxcount(rax) == 3001;
+	for (int j = 0; j < 3000; j += 2) {
+		yaslclear(key);
+		key = yaslcatprintf(key, "%c:%d", j % 200 + 1, j);
+		void * old = NULL;
+		ok = ok && !yaslraxdel(rax, key, yasllen(key), &old) && old == (void *)(intptr_t)(j + 1);
+	}
+	v = yaslraxget(rax, "\x02:2999", 6);
+	ok = ok && !v && yaslraxget(rax, "", 0) && !yaslraxdel(rax, "", 0, NULL)
+		&& (v = yaslraxget(rax, "\x02:1", 3)) && *v == (void *)2
+		&& !yaslraxget(rax, "\x02:", 2) && !yaslraxget(rax, "\x02:10", 4)
+		&& yaslraxdel(rax, "\x01:0", 3, NULL) == -1 && yaslraxcount(rax) == 1500;
+	yaslraxfree(rax);
+	return !ok;
+}
+
+declare_test(yaslrax_seek_and_prefix) {
+	struct yaslrax * rax = yaslraxnew();
+	const char * keys[] = { "user:1", "user:123", "user:12:mail", "user:12:name", "user:2", "users" };
+	struct yaslraxiter it;
+	size_t n = 0;
+	bool ok = true;
+	for (size_t j = 0; j < 6; j++) {
+		ok = ok && yaslraxput(rax, keys[5 - j], strlen(keys[5 - j]));
+	}
+	yaslraxiterinit(&it, rax);
+	ok = ok && !yaslraxseek(&it, "user:12", 7);
+	for (n = 1; !yaslraxnext(&it); n++) {
+		ok = ok && n < 6 && !strcmp(it.key, keys[n]);
+	}
+	ok = ok && n == 6 && !yaslraxprefix(&it, "user:12", 7);
+	for (n = 1; !yaslraxnext(&it); n++) {
+		ok = ok && n < 4 && !strcmp(it.key, keys[n]);
+	}
+	ok = ok && n == 4 && !yaslraxprefix(&it, "user:3", 6) && yaslraxnext(&it)
+		&& !yaslraxseek(&it, "user:13", 7) && !yaslraxnext(&it) && !strcmp(it.key, "user:2");
+	yaslraxiterfree(&it);
+	yaslraxfree(rax);
+	return !ok;
+}
+
+declare_test(yasldistance_edits) {
+	_yastr_cleanup_ yastr a = yaslempty(), b = yaslempty();
+	for (int j = 0; j < 100; j++) {
+		a = yaslcatprintf(a, "%c", 'a' + j % 7);
+	}
+	b = yaslcatlen(b, a, 40);
+	b = yaslcatlen(b, "xx", 2);
+	b = yaslcatlen(b, a + 41, 59);
+	b[80] = '?';
+	return !(yasldistance("kitten", 6, "sitting", 7, SIZE_MAX) == 3
+		&& yasldistance("sitting", 7, "kitten", 6, 3) == 3
+		&& yasldistance("kitten", 6, "sitting", 7, 2) == -1
+		&& yasldistance("", 0, "abc", 3, 3) == 3 && yasldistance("abc", 3, "", 0, 2) == -1
+		&& yasldistance("flaw", 4, "lawn", 4, SIZE_MAX) == 2
+		&& yasldistance(a, yasllen(a), b, yasllen(b), SIZE_MAX) == 3
+		&& yasldistance(b, yasllen(b), a, yasllen(a), 2) == -1
+		&& yasldistance(a, yasllen(a), a, yasllen(a), 0) == 0);
+}
+
+declare_test(yasldistfilter_candidates) {
+	yastr words[] = {
+		yaslauto("received"), yaslauto("receive"), yaslauto("deceived"),
+		yaslauto("recipe"), yaslauto("r"), yaslauto("recieved"),
+	};
+	ptrdiff_t d[6];
+	struct yasldist * dist = yasldistnew("recieved", 8);
+	bool ok = dist && yasldistfilter(dist, words, 6, 2, d) == 2
+		&& d[0] == 2 && d[1] == -1 && d[2] == -1 && d[3] == -1 && d[4] == -1 && d[5] == 0
+		&& yasldistfilter(dist, words, 6, 3, d) == 5 && d[1] == 3 && d[4] == -1
+		&& yasldistmatch(dist, "recipe", 6, SIZE_MAX) == 3;
+	yasldistfree(dist);
+	for (size_t j = 0; j < 6; j++) {
+		yaslfree(words[j]);
+	}
+	return !ok;
+}
+
+declare_test(yaslsa_count_and_locate) {
+	const size_t lcp[] = { 0, 1, 3, 0, 0, 2 }, offsets[] = { 5, 3, 1, 0, 4, 2 };
+	struct yaslsa * sa = yaslsanew("banana", 6);
+	size_t found[4], first;
+	bool ok = sa && yaslsacount(sa, "ana", 3) == 2 && yaslsacount(sa, "banana", 6) == 1
+		&& yaslsacount(sa, "nab", 3) == 0 && yaslsacount(sa, "bananas", 7) == 0
+		&& yaslsacount(sa, "", 0) == 6 && yaslsasearch(sa, "n", 1, &first) == 2 && first == 4
+		&& yaslsalocate(sa, "a", 1, found, 2) == 3 && found[0] == 5 && found[1] == 3;
+	for (size_t i = 0; ok && i < 6; i++) {
+		ok = yaslsaoffset(sa, i) == offsets[i] && yaslsalcp(sa, i) == lcp[i];
+	}
+	yaslsafree(sa);
+	return !ok;
+}
+
+declare_test(yaslsa_save_and_load) {
+	_yastr_cleanup_ yastr text = yaslempty(), buf = yaslempty();
+	for (int j = 0; j < 5000; j++) {
+		text = yaslcatprintf(text, "%d,", j * 7 % 1000);
+	}
+	struct yaslsa * sa = yaslsanewparallel(text, yasllen(text), 4), * copy;
+	buf = yaslcatsa(buf, sa);
+	copy = yaslsaload(text, yasllen(text), buf, yasllen(buf));
+	bool ok = sa && copy && !yaslsaload(text, yasllen(text) - 1, buf, yasllen(buf))
+		&& !yaslsaload(text, yasllen(text), buf, yasllen(buf) - 1)
+		&& yaslsacount(copy, "998,", 4) == 5 && yaslsacount(copy, ",1000", 5) == 0
+		&& !yaslcatsa(buf, NULL);
+	for (size_t i = 0; ok && i < yasllen(text); i++) {
+		ok = yaslsaoffset(copy, i) == yaslsaoffset(sa, i) && yaslsalcp(copy, i) == yaslsalcp(sa, i);
+	}
+	yaslsafree(copy);
+	yaslsafree(sa);
+	return !ok;
+}
+
+declare_test(yaslbuf_peek_and_release) {
+	struct yaslbuf * buf = yaslbufnew(8, 2);
+	struct iovec iov[4];
+	bool ok = buf && !yaslbufappend(buf, "hello ", 6) && yaslbufpeek(buf, iov, 4) == 0
+		&& !yaslbufappend(buf, "world!", 6) && yaslbufpeek(buf, iov, 4) == 1
+		&& iov[0].iov_len == 8 && !memcmp(iov[0].iov_base, "hello wo", 8);
+	yaslbufrelease(buf, 1);
+	yaslbufflush(buf);
+	ok = ok && yaslbufpeek(buf, iov, 4) == 1 && iov[0].iov_len == 4
+		&& !memcmp(iov[0].iov_base, "rld!", 4);
+	yaslbufrelease(buf, 1);
+	ok = ok && !yaslbufappend(buf, "abc", 3) && yaslbufpeek(buf, iov, 4) == 0
+		&& yaslbufappend(NULL, "abc", 3) == -1;
+	yaslbuffree(buf);
+	return !ok;
+}
+
+declare_test(yaslbuf_pop_segments) {
+	struct yaslbuf * buf = yaslbufnew(4, 2);
+	bool ok = buf && !yaslbufappend(buf, "abcdef", 6);
+	yastr a = yaslbufpop(buf), b = yaslbufpop(buf), c, d;
+	yaslbufflush(buf);
+	c = yaslbufpop(buf);
+	ok = ok && !yaslbufappend(buf, "ghij", 4);
+	d = yaslbufpop(buf);
+	ok = ok && a && !strcmp(a, "abcd") && !b && c && !strcmp(c, "ef") && d && !strcmp(d, "ghij");
+	yaslfree(a);
+	yaslfree(c);
+	yaslfree(d);
+	yaslbuffree(buf);
+	return !ok;
+}
+
+#define BUF_PRODUCERS 4
+#define BUF_RECORDS 5000
+
+struct buf_producer {
+	struct yaslbuf * buf;
+	unsigned char id;
+	unsigned * finished;
+};
+
+/* Append numbered records of 6 bytes: the producer, the record number and a
+ * check byte, so that torn or mixed up records are noticed. */
+static void *
+buf_produce(void * arg) {
+	struct buf_producer * p = arg;
+	for (uint32_t n = 0; n < BUF_RECORDS; n++) {
+		unsigned char rec[6] = { p->id, (unsigned char)n, (unsigned char)(n >> 8),
+		                         (unsigned char)(n >> 16), (unsigned char)(n >> 24),
+		                         (unsigned char)(p->id ^ n ^ 0xa5) };
+		if (yaslbufappend(p->buf, rec, sizeof(rec))) { break; }
+	}
+	__atomic_add_fetch(p->finished, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+declare_test(yaslbuf_concurrent_appends) {
+	struct yaslbuf * buf = yaslbufnew(8, 2);
+	struct buf_producer producers[BUF_PRODUCERS];
+	pthread_t threads[BUF_PRODUCERS];
+	uint32_t next[BUF_PRODUCERS] = { 0 };
+	unsigned finished = 0, idle = 0;
+	size_t started = 0, total = (size_t)BUF_PRODUCERS * BUF_RECORDS * 6;
+	_yastr_cleanup_ yastr out = yaslempty();
+	bool ok = buf && out;
+	for (; ok && started < BUF_PRODUCERS; started++) {
+		producers[started] = (struct buf_producer){ buf, (unsigned char)started, &finished };
+		if (pthread_create(&threads[started], NULL, buf_produce, &producers[started])) { break; }
+	}
+	/* Drain with each of the consumer calls in turn, flushing to end the
+	 * segments being written early, until the producers are done and a few
+	 * rounds bring nothing more. */
+	for (unsigned round = 0; out && idle < 6; round++) {
+		bool done = __atomic_load_n(&finished, __ATOMIC_ACQUIRE) == started;
+		size_t len = yasllen(out);
+		struct iovec iov[2];
+		size_t n = yaslbufpeek(buf, iov, 2);
+		yastr seg;
+		switch (round % 3) {
+		case 0:
+			for (size_t i = 0; i < n; i++) {
+				out = yaslcatlen(out, iov[i].iov_base, iov[i].iov_len);
+			}
+			yaslbufrelease(buf, n);
+			break;
+		case 1:
+			if ((seg = yaslbufpop(buf))) {
+				out = yaslcatyasl(out, seg);
+				yaslfree(seg);
+			}
+			break;
+		default:
+			yaslbufflush(buf);
+			break;
+		}
+		idle = done && out && yasllen(out) == len ? idle + 1 : 0;
+		sched_yield();
+	}
+	for (size_t i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	ok = ok && started == BUF_PRODUCERS && out && yasllen(out) == total;
+	for (size_t i = 0; ok && i < total; i += 6) {
+		const unsigned char * rec = (const unsigned char *)out + i;
+		uint32_t n = rec[1] | (uint32_t)rec[2] << 8 | (uint32_t)rec[3] << 16 | (uint32_t)rec[4] << 24;
+		ok = rec[0] < BUF_PRODUCERS && n == next[rec[0]]++
+			&& rec[5] == (unsigned char)(rec[0] ^ n ^ 0xa5);
+	}
+	yaslbuffree(buf);
+	return !ok;
+}
+
+declare_test(yaslsnap_round_trip) {
+	size_t count;
+	yastr * tokens = yaslsplitlen("a,bb,,ccc", 9, ",", 1, &count);
+	_yastr_cleanup_ yastr buf = yaslcatsnap(yaslempty(), tokens, count), copy = NULL;
+	struct yaslsnap * snap = yaslsnapload(buf, yasllen(buf));
+	bool ok = snap && yaslsnapcount(snap) == 4 && !strcmp(yaslsnapget(snap, 1), "bb")
+		&& yasllen(yaslsnapget(snap, 2)) == 0 && yasllen(yaslsnapget(snap, 3)) == 3
+		&& !yaslsnapget(snap, 4);
+	if (ok) {
+		yaslfree(yaslsnapget(snap, 0));
+		copy = yaslcat(yaslsnapget(snap, 3), "!");
+		ok = !strcmp(copy, "ccc!") && !strcmp(yaslsnapget(snap, 3), "ccc")
+			&& !strcmp(yaslsnapget(snap, 0), "a");
+	}
+	yaslsnapfree(snap);
+	yaslfreesplitres(tokens, count);
+	return !ok;
+}
+
+declare_test(yaslsnap_rejects_damage) {
+	yastr tokens[] = { yaslauto("alpha"), yaslauto("beta") };
+	yastr holes[] = { tokens[0], NULL };
+	_yastr_cleanup_ yastr buf = yaslcatsnap(yaslempty(), tokens, 2);
+	struct yaslsnap * snap = yaslsnapload(buf, yasllen(buf));
+	bool ok = snap && !yaslsnapload(buf, yasllen(buf) - 1) && !yaslsnapload(buf, 16)
+		&& !yaslcatsnap(buf, holes, 2) && !yaslcatsnap(buf, NULL, 1);
+	buf[yasllen(buf) - 2] ^= 1;
+	ok = ok && !yaslsnapload(buf, yasllen(buf));
+	yaslsnapfree(snap);
+	yaslfree(tokens[0]);
+	yaslfree(tokens[1]);
+	return !ok;
+}
+
+declare_test(yaslfc_find_keys) {
+	yastr keys[] = {
+		yaslauto("/usr/bin/cc"), yaslauto("/usr/bin/gcc"), yaslauto("/usr/lib/libc.so"),
+		yaslauto("/usr/lib/libm.so"), yaslauto("/usr/lib/libm.so.6"), yaslauto("/var/log"),
+	};
+	YASL_LITERAL(prefix, "> ");
+	struct yaslfc * fc = yaslfcnew(keys, 6, 2);
+	_yastr_cleanup_ yastr key = yaslcatfc(yaslauto("> "), fc, 4);
+	_yastr_cleanup_ yastr copy = yaslcatfc(prefix, fc, 3);
+	bool ok = fc && yaslfccount(fc) == 6
+		&& yaslfcfind(fc, "/usr/bin/cc", 11) == 0 && yaslfcfind(fc, "/usr/lib/libm.so", 16) == 3
+		&& yaslfcfind(fc, "/var/log", 8) == 5 && yaslfcfind(fc, "/usr/lib", 8) == -1
+		&& yaslfcfind(fc, "/usr/lib/libm.so.", 17) == -1 && yaslfcfind(fc, "/z", 2) == -1
+		&& !strcmp(key, "> /usr/lib/libm.so.6") && !yaslcatfc(key, fc, 6)
+		&& copy != prefix && !strcmp(copy, "> /usr/lib/libm.so") && !strcmp(prefix, "> ");
+	yaslfcfree(fc);
+	yastr tmp = keys[0];
+	keys[0] = keys[1];
+	keys[1] = tmp;
+	ok = ok && !yaslfcnew(keys, 6, 2);
+	for (size_t j = 0; j < 6; j++) {
+		yaslfree(keys[j]);
+	}
+	return !ok;
+}
+
+declare_test(yaslfc_seek_and_next) {
+	_yastr_cleanup_ yastr all = yaslempty();
+	yastr keys[40];
+	for (int j = 0; j < 40; j++) {
+		keys[j] = yaslcatprintf(yaslempty(), "user:%02d", j * 2);
+	}
+	struct yaslfc * fc = yaslfcnew(keys, 40, 0);
+	struct yaslfciter it;
+	yaslfciterinit(&it, fc);
+	bool ok = fc && !yaslfcseek(&it, "user:33", 7) && !yaslfcnext(&it)
+		&& it.index == 17 && !strcmp(it.key, "user:34") && !yaslfcseek(&it, "user:9", 6)
+		&& yaslfcnext(&it) == -1 && !yaslfcseek(&it, "", 0);
+	while (ok && !yaslfcnext(&it)) {
+		all = yaslcatlen(all, it.key + 5, 2);
+	}
+	ok = ok && yasllen(all) == 80 && !strncmp(all, "000204", 6) && !strcmp(all + 74, "747678");
+	yaslfciterfree(&it);
+	yaslfcfree(fc);
+	for (int j = 0; j < 40; j++) {
+		yaslfree(keys[j]);
+	}
+	return !ok;
+}
+
+declare_test(yaslresp_encode_frames) {
+	yastr argv[] = { yaslauto("SET"), yaslauto("key"), yaslauto("a\r\nb") };
+	_yastr_cleanup_ yastr out = yaslcatrespcmd(yaslempty(), argv, 3);
+	out = yaslcatresp(out, '+', "OK", 2);
+	out = yaslcatrespint(out, ':', -42);
+	out = yaslcatrespint(out, '%', 1);
+	out = yaslcatresp(out, '_', NULL, 0);
+	out = yaslcatrespint(out, '#', 1);
+	yastr holes[] = { argv[0], NULL };
+	bool ok = !yaslcatresp(out, '+', "a\r\nb", 4) && !yaslcatresp(out, '-', "a\n", 2)
+		&& !yaslcatresp(out, '?', "a", 1) && !yaslcatresp(out, '$', NULL, 1)
+		&& !yaslcatrespint(out, '?', 1) && !yaslcatrespcmd(out, holes, 2)
+		&& !yaslcatrespcmd(out, NULL, 1);
+	for (size_t j = 0; j < 3; j++) {
+		yaslfree(argv[j]);
+	}
+	return !(ok && !strcmp(out, "*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$4\r\na\r\nb\r\n+OK\r\n:-42\r\n%1\r\n_\r\n#t\r\n"));
+}
+
+declare_test(yaslresp_parse_partial) {
+	const char * wire = "*2\r\n$5\r\nhello\r\n|1\r\n+ttl\r\n:-7\r\n$-1\r\n%1\r\n+k\r\n#f\r\n";
+	const char types[] = "*$|+:_%+#";
+	_yastr_cleanup_ yastr buf = yaslempty();
+	struct yaslresp resp;
+	struct yaslrespval val;
+	size_t fed = 0, got = 0, depths[9];
+	bool ok = true;
+	yaslrespinit(&resp);
+	while (ok && got < 9) {
+		int ret = yaslrespparse(&resp, buf, yasllen(buf), &val);
+		if (ret == 0 && fed < strlen(wire)) {
+			buf = yaslcatlen(buf, wire + fed++, 1);
+			continue;
+		}
+		ok = ret == 1 && val.type == types[got];
+		depths[got++] = resp.depth;
+		if (val.type == '$') { ok = ok && val.len == 5 && !memcmp(val.str, "hello", 5); }
+		if (val.type == ':') { ok = ok && val.num == -7; }
+	}
+	ok = ok && depths[0] == 1 && depths[1] == 1 && depths[2] == 2 && depths[3] == 2
+		&& depths[4] == 1 && depths[5] == 0 && depths[6] == 1 && depths[8] == 0
+		&& yaslrespparse(&resp, buf, yasllen(buf), &val) == 0;
+	yaslrespinit(&resp);
+	return !(ok && yaslrespparse(&resp, "$3\r\nabcd\r\n", 11, &val) == -1);
+}
+
 const struct test test_list [] = {
 	{ "create a string and obtain the length",      check_string_length             },
 	{ "create a string with specified length",      create_with_length              },
@@ -229,4 +1149,61 @@ const struct test test_list [] = {
 	{ "free after yaslIncrLen()",                   yaslIncrLen_free                },
 	{ "yasltolower() with ASCII and digits",        yasltolower_ascii_digits        },
 	{ "yasltoupper() with ASCII and digits",        yasltoupper_ascii_digits        },
+	{ "yaslfind() and yaslrfind()",                 yaslfind_first_and_last         },
+	{ "yaslcount() counts non-overlapping matches", yaslcount_non_overlapping       },
+	{ "yaslreplace() with a shorter replacement",   yaslreplace_shorter             },
+	{ "yaslreplace() with a longer replacement",    yaslreplace_longer              },
+	{ "yaslreplace() with a self-overlapping match", yaslreplace_overlapping_pattern },
+	{ "yaslutf8valid() accepts and rejects",        yaslutf8valid_sequences         },
+	{ "yaslutf8len() counts code points",           yaslutf8len_counts_code_points  },
+	{ "yaslutf8range() with code point indexes",    yaslutf8range_code_points       },
+	{ "yaslutf8trunc() keeps sequences whole",      yaslutf8trunc_keeps_sequences   },
+	{ "yaslcatutf8() validates while appending",    yaslcatutf8_validates           },
+	{ "yaslcathex() and yaslcatunhex() roundtrip",  yaslcathex_roundtrip            },
+	{ "yaslcatunhex() rejects invalid input",       yaslcatunhex_rejects_invalid    },
+	{ "base64 encoding and decoding roundtrip",     yaslcatbase64_roundtrip         },
+	{ "percent encoding and decoding roundtrip",    yaslcatpercent_roundtrip        },
+	{ "yaslcatjson() escapes JSON strings",         yaslcatjson_escapes             },
+	{ "yaslcatunjson() decodes JSON strings",       yaslcatunjson_roundtrip         },
+	{ "yaslcsv with quoted fields",                 yaslcsv_quoted_fields           },
+	{ "yaslcsv with rows split across chunks",      yaslcsv_chunk_boundaries        },
+	{ "yaslcsv rejects malformed quoting",          yaslcsv_rejects_malformed       },
+	{ "yaslsplitlenvec() packs the tokens",         yaslsplitlenvec_packs_tokens    },
+	{ "yaslsplitargsvec() with quotes and errors",  yaslsplitargsvec_quotes_and_errors },
+	{ "yaslsplitargsvec() with short tokens",       yaslsplitargsvec_short_tokens   },
+	{ "yasljoinvec() and array conversion",         yaslvec_join_and_convert        },
+	{ "yaslsort() orders like yaslcmp()",           yaslsort_matches_yaslcmp        },
+	{ "yaslsortparallel() on a large array",        yaslsortparallel_large          },
+	{ "YASL_LITERAL() strings work as yastr",       yasl_literal_is_a_yastr         },
+	{ "YASL_LITERAL() strings are never modified",  yasl_literal_is_immutable       },
+	{ "yaslcat*() copy literals even for no input", yaslcat_copies_literals         },
+	{ "inline fast paths and their fallbacks",      inline_fast_paths_and_fallbacks },
+	{ "yaslcatlz() and yaslcatunlz() roundtrip",    yaslcatlz_roundtrip             },
+	{ "yaslcatunlz() rejects malformed input",      yaslcatunlz_rejects_malformed   },
+	{ "yasllz streaming roundtrip",                 yasllz_streaming_roundtrip      },
+	{ "yaslcatlonglong() at the limits",            yaslcatlonglong_limits          },
+	{ "yaslcattpl() renders like yaslcatprintf()",  yaslcattpl_renders_like_printf  },
+	{ "yasltplnew() rejects unsupported formats",   yasltplnew_rejects_unsupported  },
+	{ "yaslconsume() drops a prefix",               yaslconsume_from_the_front      },
+	{ "yaslconsume() copies static strings",        yaslconsume_static_string       },
+	{ "yaslacscan() finds all matches",             yaslac_finds_all_matches        },
+	{ "yaslacnew() rejects empty patterns",         yaslacnew_rejects_empty         },
+	{ "yaslglobmatch() with all kinds of patterns", yaslglobmatch_patterns          },
+	{ "yaslmap put, get, delete and iterate",       yaslmap_put_get_del             },
+	{ "yaslhash() spreads bits",                    yaslhash_spreads_bits           },
+	{ "yaslrax put, get and delete",                yaslrax_put_get_del             },
+	{ "yaslraxseek() and yaslraxprefix() iterate",  yaslrax_seek_and_prefix         },
+	{ "yasldistance() counts edits",                yasldistance_edits              },
+	{ "yasldistfilter() scores candidates",         yasldistfilter_candidates       },
+	{ "yaslsalocate() finds every occurrence",      yaslsa_count_and_locate         },
+	{ "yaslsaload() reads yaslcatsa() output",      yaslsa_save_and_load            },
+	{ "yaslbufpeek() returns full segments",        yaslbuf_peek_and_release        },
+	{ "yaslbufpop() returns segments as strings",   yaslbuf_pop_segments            },
+	{ "yaslbufappend() from several threads",       yaslbuf_concurrent_appends      },
+	{ "yaslsnapload() reads yaslcatsnap() output",  yaslsnap_round_trip             },
+	{ "yaslsnapload() rejects a damaged snapshot",  yaslsnap_rejects_damage         },
+	{ "yaslfcfind() finds front-coded keys",        yaslfc_find_keys                },
+	{ "yaslfcseek() and yaslfcnext() decode keys",  yaslfc_seek_and_next            },
+	{ "yaslcatrespcmd() and friends encode RESP",   yaslresp_encode_frames          },
+	{ "yaslrespparse() resumes partial input",      yaslresp_parse_partial          },
 };